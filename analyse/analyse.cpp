@@ -0,0 +1,75 @@
+#include "../board/board_state.h"
+#include "../board/minimax.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Разбор позиций: для каждой позиции, заданной в аргументах или по строке
+ * на стандартном входе, печатаются несколько лучших ходов с оценками
+ * и главными продолжениями, найденные за один поиск.
+ */
+
+namespace {
+
+void report(const std::string &notation, int count) {
+	BoardState board = BoardState::fromString(notation);
+	if (!board.color().valid()) {
+		std::cout << notation << ": bad position\n";
+		return;
+	}
+	std::cout << notation << '\n';
+	std::vector<Variation> variations = analyse(board, count);
+	if (variations.empty())
+		std::cout << "  no moves\n";
+	for (unsigned int i = 0; i < variations.size(); ++ i) {
+		const Variation &v = variations[i];
+		std::cout << "  " << i+1 << ". " << std::setw(12) << std::left << board.notation(v.action)
+		          << std::right << std::fixed << std::setprecision(4) << v.score << " ";
+		BoardState line = board;
+		for (const std::vector<Cell> &action : v.line) {
+			std::cout << ' ' << line.notation(action);
+			BoardState::apply(line, action);
+		}
+		std::cout << '\n';
+	}
+}
+
+}
+
+int main(int argc, char **argv) {
+	int count = 3;
+	std::vector<std::string> positions;
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if (arg == "--multipv" && i+1 < argc)
+			count = std::max(1, std::atoi(argv[++ i]));
+		else if (arg == "--weights" && i+1 < argc) {
+			Weights weights;
+			if (!weights.load(argv[++ i])) {
+				std::cerr << "Cannot load weights from " << argv[i] << '\n';
+				return 1;
+			}
+			useWeights(weights);
+		}
+		else if (!arg.empty() && arg[0] != '-')
+			positions.push_back(arg);
+		else {
+			std::cerr << "Usage: analyse [--multipv K] [--weights FILE] [POSITION...]\n"
+			             "Without positions, reads one position per line from standard input.\n";
+			return 1;
+		}
+	}
+	if (!positions.empty())
+		for (const std::string &notation : positions)
+			report(notation, count);
+	else {
+		std::string line;
+		while (std::getline(std::cin, line))
+			if (!line.empty())
+				report(line, count);
+	}
+	return 0;
+}
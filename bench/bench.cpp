@@ -0,0 +1,283 @@
+#include "../board/board_state.h"
+#include "../board/minimax.h"
+#include "../board/batch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Замеры элементарных операций библиотеки board на нескольких характерных
+ * позициях. Каждая операция прогоняется пачками: сначала несколько пачек
+ * на разогрев (по ним же подбирается размер пачки), затем заданное число
+ * замеряемых пачек. По замерам выводится время одной операции в наносекундах.
+ */
+
+struct BoardProbe {
+	static void forage(BoardState &board) {board.forage();}
+	static std::size_t browse(const BoardState &board, Cell start, Direction path) {
+		return board.browse(start, path).size();
+	}
+};
+
+namespace {
+
+struct Sample {
+	const char *name;
+	const char *notation;
+};
+
+const Sample Samples[] = {
+	{"opening", "W:WA1,C1,E1,G1,B2,D2,F2,H2,A3,C3,E3,G3:BB6,D6,F6,H6,A7,C7,E7,G7,B8,D8,F8,H8"},
+	{"middlegame", "W:WA1,C1,E1,B2,F2,C3,E3,G3,D4:BB6,F6,H6,A7,C7,G7,E5,D8,H8"},
+	{"endgame", "B:WKC1,KG5,E3:BKH8,KA7,B6"},
+};
+
+struct Options {
+	int repetitions = 10;
+	int warmup = 3;
+	double minTime = 0.01;     // Наименьшая длительность пачки, в секундах.
+	bool json = false;
+	std::string filter;
+};
+
+struct Summary {
+	double min, median, mean, stddev, max;
+};
+
+Summary summarize(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	Summary s;
+	std::size_t n = values.size();
+	s.min = values.front();
+	s.max = values.back();
+	s.median = n % 2 ? values[n/2] : (values[n/2-1] + values[n/2]) / 2.0;
+	double sum = 0.0;
+	for (double v : values)
+		sum += v;
+	s.mean = sum / n;
+	double square = 0.0;
+	for (double v : values)
+		square += (v - s.mean) * (v - s.mean);
+	s.stddev = n > 1 ? std::sqrt(square / (n-1)) : 0.0;
+	return s;
+}
+
+// Операция совершает некоторое число вызовов и возвращает это число.
+using Operation = std::function<std::size_t ()>;
+
+struct Result {
+	std::string name;
+	std::string position;
+	std::string notation;
+	long long batch;       // Число прогонов операции в одной пачке.
+	std::size_t calls;     // Число вызовов замеряемой процедуры за один прогон.
+	Summary ns;
+};
+
+volatile std::size_t sink;   // Не даёт компилятору выбросить результаты операций.
+
+double runBatch(const Operation &operation, long long batch, std::size_t &calls) {
+	auto start = std::chrono::steady_clock::now();
+	std::size_t total = 0;
+	for (long long i = 0; i < batch; ++ i)
+		total += operation();
+	auto finish = std::chrono::steady_clock::now();
+	calls = batch ? total / batch : 0;
+	sink = sink + total;
+	return std::chrono::duration<double>(finish - start).count();
+}
+
+Result measure(const Options &options, std::string name, const Sample &sample, const Operation &operation) {
+	Result result;
+	result.name = name;
+	result.position = sample.name;
+	result.notation = sample.notation;
+	long long batch = 1;
+	std::size_t calls = 0;
+	for (int i = 0; i < options.warmup || i == 0; ++ i) {
+		double elapsed = runBatch(operation, batch, calls);
+		while (elapsed < options.minTime) {
+			batch *= 2;
+			elapsed = runBatch(operation, batch, calls);
+		}
+	}
+	std::vector<double> values;
+	for (int i = 0; i < options.repetitions; ++ i) {
+		double elapsed = runBatch(operation, batch, calls);
+		values.push_back(calls ? elapsed * 1e9 / (batch * calls) : 0.0);
+	}
+	result.batch = batch;
+	result.calls = calls;
+	result.ns = summarize(values);
+	return result;
+}
+
+// Набор замеряемых операций для одной позиции.
+std::vector<std::pair<std::string, Operation>> operations(const BoardState &board) {
+	std::vector<std::pair<std::string, Operation>> list;
+	std::vector<std::vector<Cell>> actions = explore(board);
+	std::vector<Cell> action = actions.empty() ? std::vector<Cell>() : actions.front();
+	Role color = board.color();
+
+	list.emplace_back("control", [board, action]() -> std::size_t {
+		BoardState copy = board;
+		std::size_t count = 0;
+		for (Cell cell : action)
+			count += copy.control(cell);
+		return count;
+	});
+	list.emplace_back("browse", [board, color]() -> std::size_t {
+		std::size_t count = 0, size = 0;
+		for (Cell stone : board.position().stock(color))
+			for (Direction direction : Direction::enumerate()) {
+				size += BoardProbe::browse(board, stone, direction);
+				++ count;
+			}
+		sink = sink + size;
+		return count;
+	});
+	list.emplace_back("forage", [board]() -> std::size_t {
+		BoardState copy = board;
+		BoardProbe::forage(copy);
+		sink = sink + copy.quiet();
+		return 1;
+	});
+	list.emplace_back("lost", [board]() -> std::size_t {
+		sink = sink + board.lost();
+		return 1;
+	});
+	list.emplace_back("captures", [board]() -> std::size_t {
+		const Position &position = board.position();
+		std::size_t count = 0, found = 0;
+		for (Cell stone : position.stock(Role::None))
+			for (Direction direction : Direction::enumerate()) {
+				found += position.captures(stone, direction);
+				++ count;
+			}
+		sink = sink + found;
+		return count;
+	});
+	list.emplace_back("neighbour", []() -> std::size_t {
+		std::size_t count = 0, found = 0;
+		for (unsigned int i = 0; i < 32; ++ i)
+			for (Direction direction : Direction::enumerate()) {
+				found += Cell::fromIndex(i).neighbour(direction).valid();
+				++ count;
+			}
+		sink = sink + found;
+		return count;
+	});
+	list.emplace_back("explore", [board]() -> std::size_t {
+		sink = sink + explore(board).size();
+		return 1;
+	});
+	list.emplace_back("distinct", [board]() -> std::size_t {
+		sink = sink + distinct(board).size();
+		return 1;
+	});
+	list.emplace_back("evaluate", [board]() -> std::size_t {
+		sink = sink + static_cast<std::size_t>(evaluate(board) * 1000.0);
+		return 1;
+	});
+	std::shared_ptr<Batch> batch(new Batch);
+	for (int i = 0; i < 256; ++ i)
+		batch->append(board);
+	for (Batch::Kernel kernel : {Batch::Scalar, Batch::Popcnt, Batch::Avx2}) {
+		if (!Batch::supported(kernel))
+			continue;
+		list.emplace_back(std::string("batch-") + Batch::name(kernel), [batch, kernel]() -> std::size_t {
+			double scores[256];
+			batch->evaluate(scores, kernel);
+			sink = sink + static_cast<std::size_t>(scores[0] * 1000.0);
+			return batch->size();
+		});
+	}
+	return list;
+}
+
+void printText(const std::vector<Result> &results) {
+	std::cout << std::left << std::setw(16) << "operation" << std::setw(12) << "position"
+	          << std::right << std::setw(12) << "min" << std::setw(12) << "median"
+	          << std::setw(12) << "mean" << std::setw(12) << "stddev" << std::setw(12) << "max"
+	          << "  (ns/op)\n";
+	std::cout << std::fixed << std::setprecision(1);
+	for (const Result &r : results)
+		std::cout << std::left << std::setw(16) << r.name << std::setw(12) << r.position
+		          << std::right << std::setw(12) << r.ns.min << std::setw(12) << r.ns.median
+		          << std::setw(12) << r.ns.mean << std::setw(12) << r.ns.stddev
+		          << std::setw(12) << r.ns.max << '\n';
+}
+
+void printJson(const Options &options, const std::vector<Result> &results) {
+	std::cout << std::setprecision(3) << std::fixed;
+	std::cout << "{\n  \"repetitions\": " << options.repetitions
+	          << ",\n  \"warmup\": " << options.warmup
+	          << ",\n  \"benchmarks\": [";
+	for (std::size_t i = 0; i < results.size(); ++ i) {
+		const Result &r = results[i];
+		std::cout << (i ? ",\n" : "\n")
+		          << "    {\"name\": \"" << r.name << "\", \"position\": \"" << r.position
+		          << "\", \"notation\": \"" << r.notation << "\", \"batch\": " << r.batch
+		          << ", \"calls\": " << r.calls
+		          << ", \"ns_per_op\": {\"min\": " << r.ns.min << ", \"median\": " << r.ns.median
+		          << ", \"mean\": " << r.ns.mean << ", \"stddev\": " << r.ns.stddev
+		          << ", \"max\": " << r.ns.max << "}}";
+	}
+	std::cout << "\n  ]\n}\n";
+}
+
+void usage() {
+	std::cerr << "Usage: board_bench [--json] [--repetitions N] [--warmup N]"
+	             " [--min-time MS] [--filter NAME]\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+	Options options;
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		bool more = i+1 < argc;
+		if (arg == "--json")
+			options.json = true;
+		else if (arg == "--repetitions" && more)
+			options.repetitions = std::max(1, std::atoi(argv[++ i]));
+		else if (arg == "--warmup" && more)
+			options.warmup = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--min-time" && more)
+			options.minTime = std::max(0.0, std::atof(argv[++ i]) / 1000.0);
+		else if (arg == "--filter" && more)
+			options.filter = argv[++ i];
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	std::vector<Result> results;
+	for (const Sample &sample : Samples) {
+		BoardState board = BoardState::fromString(sample.notation);
+		if (!board.color().valid()) {
+			std::cerr << "Bad sample position: " << sample.notation << '\n';
+			return 1;
+		}
+		for (const auto &entry : operations(board)) {
+			if (!options.filter.empty() && entry.first.find(options.filter) == std::string::npos)
+				continue;
+			results.push_back(measure(options, entry.first, sample, entry.second));
+		}
+	}
+	if (options.json)
+		printJson(options, results);
+	else
+		printText(results);
+	return 0;
+}
@@ -0,0 +1,255 @@
+#include "batch.h"
+#include "bits.h"
+#include "minimax.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Поражение определяется по маскам: игрок, который должен ходить, проиграл,
+ * если ни одна его шашка не может ни сделать тихий ход, ни бить соседнюю
+ * шашку противника. Дальнобойность дамки здесь не важна: если дамка может
+ * сойти с места, у неё уже есть тихий ход.
+ */
+
+namespace {
+
+struct Lane {
+	std::uint32_t white, black, kings;
+	bool blackToMove;
+};
+
+inline double score(Lane lane, const Weights &weights) {
+	std::uint32_t own = lane.blackToMove ? lane.black : lane.white;
+	std::uint32_t other = lane.blackToMove ? lane.white : lane.black;
+	std::uint32_t empty = ~(own | other);
+	std::uint32_t men = own & ~lane.kings, kings = own & lane.kings;
+	std::uint32_t forward = lane.blackToMove
+		? shiftLeftBackward(men) | shiftRightBackward(men)
+		: shiftLeftForward(men) | shiftRightForward(men);
+	std::uint32_t quiet = forward | shiftLeftForward(kings) | shiftRightForward(kings)
+		| shiftLeftBackward(kings) | shiftRightBackward(kings);
+	std::uint32_t jumps = shiftLeftForward(shiftLeftForward(own) & other)
+		| shiftRightForward(shiftRightForward(own) & other)
+		| shiftLeftBackward(shiftLeftBackward(own) & other)
+		| shiftRightBackward(shiftRightBackward(own) & other);
+	if (!((quiet | jumps) & empty))
+		return lane.blackToMove ? WhiteWin : BlackWin;
+	double wc = weights.strength(Material(lane.white, lane.kings, Role::White));
+	double bc = weights.strength(Material(lane.black, lane.kings, Role::Black));
+	return wc/bc;
+}
+
+inline Lane lane(const std::uint32_t *white, const std::uint32_t *black, const std::uint32_t *kings,
+                 const std::uint8_t *color, std::size_t i) {
+	Lane result = {white[i], black[i], kings[i], color[i] == Role::Black};
+	return result;
+}
+
+void scalar(const std::uint32_t *white, const std::uint32_t *black, const std::uint32_t *kings,
+            const std::uint8_t *color, std::size_t size, const Weights &weights, double *scores) {
+	for (std::size_t i = 0; i < size; ++ i)
+		scores[i] = score(lane(white, black, kings, color, i), weights);
+}
+
+#ifdef BATCH_X86
+
+__attribute__((target("sse4.2,popcnt")))
+void popcnt(const std::uint32_t *white, const std::uint32_t *black, const std::uint32_t *kings,
+            const std::uint8_t *color, std::size_t size, const Weights &weights, double *scores) {
+	for (std::size_t i = 0; i < size; ++ i)
+		scores[i] = score(lane(white, black, kings, color, i), weights);
+}
+
+// Восемь позиций за раз; каждая маска занимает 32-битную дорожку регистра.
+
+__attribute__((target("avx2")))
+inline __m256i leftForward(__m256i m) {
+	__m256i even = _mm256_set1_epi32(EvenRanks & ~FileA), odd = _mm256_set1_epi32(OddRanks);
+	return _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(m, even), 3),
+	                       _mm256_slli_epi32(_mm256_and_si256(m, odd), 4));
+}
+
+__attribute__((target("avx2")))
+inline __m256i rightForward(__m256i m) {
+	__m256i even = _mm256_set1_epi32(EvenRanks), odd = _mm256_set1_epi32(OddRanks & ~FileH);
+	return _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(m, even), 4),
+	                       _mm256_slli_epi32(_mm256_and_si256(m, odd), 5));
+}
+
+__attribute__((target("avx2")))
+inline __m256i leftBackward(__m256i m) {
+	__m256i even = _mm256_set1_epi32(EvenRanks & ~FileA), odd = _mm256_set1_epi32(OddRanks);
+	return _mm256_or_si256(_mm256_srli_epi32(_mm256_and_si256(m, even), 5),
+	                       _mm256_srli_epi32(_mm256_and_si256(m, odd), 4));
+}
+
+__attribute__((target("avx2")))
+inline __m256i rightBackward(__m256i m) {
+	__m256i even = _mm256_set1_epi32(EvenRanks), odd = _mm256_set1_epi32(OddRanks & ~FileH);
+	return _mm256_or_si256(_mm256_srli_epi32(_mm256_and_si256(m, even), 4),
+	                       _mm256_srli_epi32(_mm256_and_si256(m, odd), 3));
+}
+
+__attribute__((target("avx2")))
+inline __m256i population(__m256i v) {
+	const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	__m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibble));
+	__m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+	__m256i bytes = _mm256_add_epi8(low, high);
+	__m256i pairs = _mm256_maddubs_epi16(bytes, _mm256_set1_epi8(1));
+	return _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+}
+
+__attribute__((target("avx2")))
+inline __m128i part(__m256i v, int upper) {
+	return upper ? _mm256_extracti128_si256(v, 1) : _mm256_castsi256_si128(v);
+}
+
+__attribute__((target("avx2")))
+inline __m256d widen(__m128i mask) {
+	return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(mask));
+}
+
+// Признаки Material одной стороны в восьми позициях; продвижение — сумма маскированных подсчётов.
+struct Lanes {
+	__m256i men, kings, advance, centre;
+};
+
+__attribute__((target("avx2")))
+inline Lanes features(__m256i own, __m256i kings, Role color) {
+	Lanes f;
+	__m256i men = _mm256_andnot_si256(kings, own);
+	f.men = population(men);
+	f.kings = population(_mm256_and_si256(own, kings));
+	f.advance = _mm256_setzero_si256();
+	for (unsigned int rank = 1; rank < 8; ++ rank) {
+		std::uint32_t ranks = color == Role::White ? RanksFrom[rank] : RanksUpTo[7-rank];
+		__m256i mask = _mm256_set1_epi32(static_cast<int>(ranks));
+		f.advance = _mm256_add_epi32(f.advance, population(_mm256_and_si256(men, mask)));
+	}
+	f.centre = population(_mm256_and_si256(own, _mm256_set1_epi32(Centre)));
+	return f;
+}
+
+// Сила стороны в четырёх позициях, с тем же порядком действий, что в Weights::strength().
+__attribute__((target("avx2")))
+inline __m256d strength(const Lanes &f, int upper, const Weights &weights) {
+	__m256d sum = _mm256_add_pd(
+		_mm256_mul_pd(_mm256_set1_pd(weights.man), _mm256_cvtepi32_pd(part(f.men, upper))),
+		_mm256_mul_pd(_mm256_set1_pd(weights.king), _mm256_cvtepi32_pd(part(f.kings, upper))));
+	sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_set1_pd(weights.advance), _mm256_cvtepi32_pd(part(f.advance, upper))));
+	return _mm256_add_pd(sum, _mm256_mul_pd(_mm256_set1_pd(weights.centre), _mm256_cvtepi32_pd(part(f.centre, upper))));
+}
+
+__attribute__((target("avx2")))
+void avx2(const std::uint32_t *white, const std::uint32_t *black, const std::uint32_t *kings,
+          const std::uint8_t *color, std::size_t size, const Weights &weights, double *scores) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i all = _mm256_set1_epi32(-1);
+	const __m256d whiteWin = _mm256_set1_pd(WhiteWin), blackWin = _mm256_set1_pd(BlackWin);
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		__m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(white + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(black + i));
+		__m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kings + i));
+		__m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(color + i));
+		__m256i side = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(c), _mm256_set1_epi32(Role::Black));
+
+		__m256i own = _mm256_blendv_epi8(w, b, side);
+		__m256i other = _mm256_blendv_epi8(b, w, side);
+		__m256i empty = _mm256_xor_si256(_mm256_or_si256(own, other), all);
+		__m256i men = _mm256_andnot_si256(k, own), queens = _mm256_and_si256(k, own);
+		__m256i forward = _mm256_blendv_epi8(
+			_mm256_or_si256(leftForward(men), rightForward(men)),
+			_mm256_or_si256(leftBackward(men), rightBackward(men)), side);
+		__m256i quiet = _mm256_or_si256(
+			_mm256_or_si256(forward, _mm256_or_si256(leftForward(queens), rightForward(queens))),
+			_mm256_or_si256(leftBackward(queens), rightBackward(queens)));
+		__m256i jumps = _mm256_or_si256(
+			_mm256_or_si256(leftForward(_mm256_and_si256(leftForward(own), other)),
+			                rightForward(_mm256_and_si256(rightForward(own), other))),
+			_mm256_or_si256(leftBackward(_mm256_and_si256(leftBackward(own), other)),
+			                rightBackward(_mm256_and_si256(rightBackward(own), other))));
+		__m256i moves = _mm256_and_si256(_mm256_or_si256(quiet, jumps), empty);
+		__m256i lost = _mm256_cmpeq_epi32(moves, zero);
+
+		Lanes wf = features(w, k, Role::White), bf = features(b, k, Role::Black);
+		for (int upper = 0; upper < 2; ++ upper) {
+			__m256d ratio = _mm256_div_pd(strength(wf, upper, weights), strength(bf, upper, weights));
+			__m256d final = _mm256_blendv_pd(blackWin, whiteWin, widen(part(side, upper)));
+			_mm256_storeu_pd(scores + i + 4*upper, _mm256_blendv_pd(ratio, final, widen(part(lost, upper))));
+		}
+	}
+	scalar(white + i, black + i, kings + i, color + i, size - i, weights, scores + i);
+}
+
+#endif
+
+using Function = void (*)(const std::uint32_t*, const std::uint32_t*, const std::uint32_t*,
+                          const std::uint8_t*, std::size_t, const Weights&, double*);
+
+Function function(Batch::Kernel kernel) {
+	switch (kernel) {
+#ifdef BATCH_X86
+	case Batch::Avx2: return avx2;
+	case Batch::Popcnt: return popcnt;
+#endif
+	default: return scalar;
+	}
+}
+
+}
+
+bool Batch::supported(Kernel kernel) {
+	switch (kernel) {
+	case Scalar: return true;
+#ifdef BATCH_X86
+	case Popcnt: return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+	case Avx2: return __builtin_cpu_supports("avx2");
+#endif
+	default: return false;
+	}
+}
+
+Batch::Kernel Batch::best() {
+	static const Kernel kernel = supported(Avx2) ? Avx2 : supported(Popcnt) ? Popcnt : Scalar;
+	return kernel;
+}
+
+const char* Batch::name(Kernel kernel) {
+	switch (kernel) {
+	case Scalar: return "scalar";
+	case Popcnt: return "sse4.2";
+	case Avx2: return "avx2";
+	default: return "";
+	}
+}
+
+void Batch::append(const BoardState &board) {
+	_white.push_back(board.position().mask(Role::White));
+	_black.push_back(board.position().mask(Role::Black));
+	_kings.push_back(board.position().kings());
+	_color.push_back(static_cast<std::uint8_t>(static_cast<int>(board.color())));
+}
+
+void Batch::clear() {
+	_white.clear();
+	_black.clear();
+	_kings.clear();
+	_color.clear();
+}
+
+std::size_t Batch::size() const {return _color.size();}
+
+void Batch::evaluate(double *scores) const {evaluate(scores, best());}
+
+void Batch::evaluate(double *scores, Kernel kernel) const {
+	if (!supported(kernel))
+		kernel = Scalar;
+	function(kernel)(_white.data(), _black.data(), _kings.data(), _color.data(), size(), weights(), scores);
+}
@@ -0,0 +1,34 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <vector>
+#include "board_state.h"
+
+/*
+ * Пачка позиций для совместной оценки. Позиции хранятся по столбцам: маски
+ * белых шашек, чёрных шашек и дамок, цвет игрока, который должен ходить.
+ * Оценка каждой позиции совпадает с evaluate() для неё; ядро выбирается
+ * по возможностям процессора при первом обращении.
+ */
+
+class Batch {
+public:
+	enum Kernel {Scalar = 0, Popcnt, Avx2};
+	static Kernel best ();                   // Самое быстрое ядро на этом процессоре.
+	static bool supported (Kernel kernel);
+	static const char* name (Kernel kernel);
+public:
+	void append (const BoardState &board);   // Полуход в позиции должен быть завершён.
+	void clear ();
+	std::size_t size () const;
+	void evaluate (double *scores) const;    // По одной оценке на позицию, в порядке добавления.
+	void evaluate (double *scores, Kernel kernel) const;
+private:
+	std::vector<std::uint32_t> _white;
+	std::vector<std::uint32_t> _black;
+	std::vector<std::uint32_t> _kings;
+	std::vector<std::uint8_t> _color;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <cstdint>
+
+// Операции над битовыми масками полей: бит i соответствует Cell::fromIndex(i).
+
+inline unsigned int countBits (std::uint32_t mask) {
+#if defined(__GNUC__)
+	return __builtin_popcount(mask);
+#else
+	unsigned int count = 0;
+	for (; mask; mask &= mask-1)
+		++ count;
+	return count;
+#endif
+}
+
+inline unsigned int lowestBit (std::uint32_t mask) {    // Маска не должна быть пустой.
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	unsigned int index = 0;
+	while (!(mask & 1u)) {
+		mask >>= 1;
+		++ index;
+	}
+	return index;
+#endif
+}
+
+/*
+ * Сдвиг маски на одно поле по направлению. Поля с индексами i хранятся по
+ * четыре на горизонталь; на чётных горизонталях (считая с нуля) шашки стоят
+ * на вертикалях a, c, e, g, на нечётных — на b, d, f, h. Поэтому шаг меняет
+ * индекс на разную величину в зависимости от чётности горизонтали, а поля
+ * у края доски, с которых шаг невозможен, отбрасываются.
+ */
+
+const std::uint32_t EvenRanks = 0x0F0F0F0Fu;
+const std::uint32_t OddRanks = 0xF0F0F0F0u;
+const std::uint32_t FileA = 0x01010101u;
+const std::uint32_t FileH = 0x80808080u;
+const std::uint32_t Centre = 0x00666600u;     // c3, e3, d4, f4, c5, e5, d6, f6.
+
+// RanksFrom[r] — горизонтали с r-й до последней; RanksUpTo[r] — с первой до r-й.
+const std::uint32_t RanksFrom[8] = {
+	0xFFFFFFFFu, 0xFFFFFFF0u, 0xFFFFFF00u, 0xFFFFF000u,
+	0xFFFF0000u, 0xFFF00000u, 0xFF000000u, 0xF0000000u,
+};
+const std::uint32_t RanksUpTo[8] = {
+	0x0000000Fu, 0x000000FFu, 0x00000FFFu, 0x0000FFFFu,
+	0x000FFFFFu, 0x00FFFFFFu, 0x0FFFFFFFu, 0xFFFFFFFFu,
+};
+
+inline std::uint32_t shiftLeftForward (std::uint32_t m) {
+	return ((m & EvenRanks & ~FileA) << 3) | ((m & OddRanks) << 4);
+}
+
+inline std::uint32_t shiftRightForward (std::uint32_t m) {
+	return ((m & EvenRanks) << 4) | ((m & OddRanks & ~FileH) << 5);
+}
+
+inline std::uint32_t shiftLeftBackward (std::uint32_t m) {
+	return ((m & EvenRanks & ~FileA) >> 5) | ((m & OddRanks) >> 4);
+}
+
+inline std::uint32_t shiftRightBackward (std::uint32_t m) {
+	return ((m & EvenRanks) >> 4) | ((m & OddRanks & ~FileH) >> 3);
+}
+
+#endif
@@ -23,6 +23,99 @@ BoardState BoardState::initialBoard() {
 	return BoardState(Position(cells), Role::White);
 }
 
+/*
+ * Запись позиции: цвет игрока, который должен ходить, затем поля белых шашек,
+ * затем поля чёрных шашек; дамки помечены буквой K. Например, "W:WA1,KC3:BH8".
+ */
+
+BoardState BoardState::fromString(std::string str) {
+	Position::Stone cells[32];
+	Role start, section;
+	std::string::size_type begin = 0;
+	while (begin <= str.size()) {
+		std::string::size_type end = str.find_first_of(":,", begin);
+		if (end == std::string::npos)
+			end = str.size();
+		std::string word = str.substr(begin, end-begin);
+		if (begin == 0 || str[begin-1] == ':') {
+			if (word.empty() || (word[0] != 'W' && word[0] != 'B'))
+				return BoardState();
+			Role tag = word[0] == 'W' ? Role::White : Role::Black;
+			word.erase(0, 1);
+			if (begin == 0) {
+				if (!word.empty())
+					return BoardState();
+				start = tag;
+			}
+			else
+				section = tag;
+		}
+		if (!word.empty()) {
+			bool king = word[0] == 'K';
+			Cell cell = Cell::fromString(king ? word.substr(1) : word);
+			if (!section.valid() || !cell.valid() || cells[cell.index()].color.valid())
+				return BoardState();
+			cells[cell.index()] = Position::Stone(section, king);
+		}
+		begin = end+1;
+	}
+	return BoardState(Position(cells), start);
+}
+
+std::string BoardState::str() const {
+	if (!_color.valid() || !finished())
+		return std::string();
+	std::string result(1, _color == Role::White ? 'W' : 'B');
+	for (Role role = Role::White; role.valid(); role = role.next()) {
+		result += role == Role::White ? ":W" : ":B";
+		bool first = true;
+		for (Cell cell : _position.stock(role)) {
+			if (!first)
+				result.push_back(',');
+			if (_position.king(cell))
+				result.push_back('K');
+			result += cell.str();
+			first = false;
+		}
+	}
+	return result;
+}
+
+/*
+ * Запись хода: начальное поле, поля, на которых шашка поворачивает, и
+ * конечное поле. Поля разделены знаком ":", если ход содержит взятия,
+ * и знаком "-" иначе. Для недопустимого хода запись пуста.
+ */
+
+std::string BoardState::notation(std::vector<Cell> action) const {
+	BoardState board = *this;
+	std::vector<Cell> points;
+	bool capture = false;
+	Direction direction;
+	for (unsigned int i = 0; i < action.size(); ++ i) {
+		if (!board.control(action[i]))
+			return std::string();
+		capture = capture || board.capture();
+		if (i == 0 || !action[i].valid())
+			continue;
+		Direction next = action[i-1].connection(action[i]);
+		if (i > 1 && next != direction)
+			points.push_back(action[i-1]);
+		direction = next;
+	}
+	if (action.empty() || !board.finished())
+		return std::string();
+	points.insert(points.begin(), action.front());
+	points.push_back(action[action.size()-2]);
+	std::string result;
+	for (Cell cell : points) {
+		if (!result.empty())
+			result.push_back(capture ? ':' : '-');
+		result += cell.str();
+	}
+	return result;
+}
+
 BoardState::BoardState () : _color(Role::None) {}
 BoardState::BoardState (const Position &position, Role start)
 	: _position(position), _color(start) {forage();}
@@ -32,6 +125,8 @@ Cell BoardState::place () const {return _view.empty() ? _start : _view[_location
 bool BoardState::capture () const {return !_view.empty() && _view[_location].cell.capture();}
 bool BoardState::finished () const {return !_start.valid();}
 bool BoardState::quiet () const {return finished() && !_hungry;}
+bool BoardState::hasCapture () const {return finished() && _hungry;}
+bool BoardState::hasMove () const {return !lost();}
 
 /*
  * Движение шашки разделено на сегменты, когда шашка проходит по одной диагонали.
@@ -144,25 +239,15 @@ bool BoardState::untimelyStop () const {
 bool BoardState::lost () const {
 	if (_start.valid())
 		return false;
-	std::vector<Cell> stones = _position.stock(_color);
-	for (Cell stone : stones)
-		if (free(stone))
-			return false;
-	return true;
+	return !_hungry && !_position.canMove(_color);
 }
 
 void BoardState::forage () {
-	_hungry = false;
-	std::vector<Cell> stones = _position.stock(_color);
-	for (Cell stone : stones)
-		if (hungry(stone)) {
-			_hungry = true;
-			return;
-		}
+	_hungry = _position.canCapture(_color);
 }
 
 bool BoardState::free (Cell stone) const {
-	const std::vector<Direction>& directions = Direction::enumerate();
+	Span<Direction> directions = Direction::enumerate();
 	for (Direction direction : directions)
 		if (_position.accepts(stone, direction) != Position::Block)
 			return true;
@@ -170,7 +255,7 @@ bool BoardState::free (Cell stone) const {
 }
 
 bool BoardState::hungry (Cell stone) const {
-	const std::vector<Direction>& directions = Direction::enumerate();
+	Span<Direction> directions = Direction::enumerate();
 	for (Direction direction : directions)
 		if (_position.captures(stone, direction))
 			return true;
@@ -196,8 +281,8 @@ bool BoardState::hungry (Cell stone) const {
  * она ещё может брать вперёд: на это поле она зайти обязательно может.
  */
 
-std::vector<BoardState::Location> BoardState::browse (Cell start, Direction path) const {
-	std::vector<Location> answer;
+BoardState::View BoardState::browse (Cell start, Direction path) const {
+	View answer;
 	Segment segment(_position, start, path);
 	Role color = _position.color(start);
 	bool king = _position.king(start);
@@ -248,6 +333,6 @@ std::vector<BoardState::Location> BoardState::browse (Cell start, Direction path
 		if (i == 0 || forwardHungry || obliqueHungry)
 			answer[i].stop = false;
 	}
-	answer.erase(answer.begin()+i, answer.end());
+	answer.resize(i);
 	return answer;
 }
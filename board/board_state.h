@@ -5,6 +5,10 @@
 #include "direction.h"
 #include "cell.h"
 #include "role.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 /*
  * Автомат по изменению состояния доски, действующий по правилам русских шашек.
@@ -17,23 +21,31 @@
  *   3) останов (пустое поле).
  * Автомат сам решает, когда эти действия надо сопровождать уничтожением
  * шашек противоположного цвета (взятиями) или возведением шашки в дамки.
+ *
+ * Состояние целиком лежит внутри объекта, без динамической памяти,
+ * поэтому копия автомата — простое копирование байтов.
  */
 
 class BoardState {
 public:
 	static bool apply (BoardState& board, std::vector<Cell> action);
 	static BoardState initialBoard();
+	static BoardState fromString (std::string str);    // Позиция в записи вида "W:WA1,KC3:BH8".
 public:
 	BoardState ();
 	BoardState (const Position &position, Role start);
 	bool control (Cell location);    // Совершить единичное действие над автоматом.
 	bool lost () const;              // Игрок, который должен ходить, не может ходить.
 	bool quiet () const;             // Истина, если никакая шашка не может бить.
+	bool hasCapture () const;        // Полуход не начат, и ходящий обязан бить.
+	bool hasMove () const;           // Игрок, который должен ходить, может ходить.
 	bool capture () const;           // Истина, если совершённое действие — взятие.
 	bool finished () const;          // Никакая шашка не начала движение в полуходе.
 	Cell place () const;             // Здесь находится шашка, начавшая движение.
 	Role color () const;             // Таков цвет шашки, которая должна ходить.
 	const Position& position () const;
+	std::string str () const;        // Запись позиции; пуста, пока шашка движется.
+	std::string notation (std::vector<Cell> action) const;    // Запись хода вида "C3:E5:C7".
 private:    // Самое общее состояние доски:
 	Position _position;
 	Role _color;           // Вариант правил игры: для белых или для чёрных.
@@ -47,9 +59,26 @@ private:    // Что шашка может делать, пока движет
 		bool left;                // Шашка может отсюда брать влево.
 		bool right;               // Шашка может отсюда брать вправо.
 		bool stop;                // Можно здесь и завершить ход.
+		Location() = default;
 		Location(Cell c, bool l, bool r) : cell(c), left(l), right(r), stop(true) {}
 	};
-	std::vector<Location> _view;    // Распорядок движения по диагонали.
+	// Распорядок движения по диагонали; он не длиннее самой диагонали.
+	class View {
+	public:
+		static const unsigned int Capacity = 8;
+		View () : _size(0) {}
+		bool empty () const {return _size == 0;}
+		unsigned int size () const {return _size;}
+		void clear () {_size = 0;}
+		void push_back (const Location &location) {_items[_size ++] = location;}
+		void resize (unsigned int size) {_size = size;}
+		Location& operator[] (unsigned int i) {return _items[i];}
+		const Location& operator[] (unsigned int i) const {return _items[i];}
+	private:
+		Location _items[Capacity];
+		std::uint8_t _size;
+	};
+	View _view;
 	Direction _direction;      // Направление, по которому движется шашка.
 	Cell _start;               // Поле, с которого шашка начала ход.
 	int _location;             // Текущее положение на диагонали.
@@ -64,7 +93,10 @@ private:    // Функции, возвращающие true при некорр
 	bool crazyAdvance () const;        // Шашка не может идти дальше по диагонали.
 	bool untimelyStop () const;        // Пока рано завершать ход.
 private:
-	std::vector<Location> browse (Cell start, Direction path) const;
+	View browse (Cell start, Direction path) const;
+	friend struct BoardProbe;    // Доступ для измерительных и проверочных программ.
 };
 
+static_assert(std::is_trivially_copyable<BoardState>::value, "BoardState must copy without allocation");
+
 #endif
@@ -1,39 +1,49 @@
 #include "cell.h"
 #include <cstdlib>
 
-const unsigned int Cell::None = 80;
-const Cell::StaticTable Cell::_table;
+const unsigned int Cell::None;
+constexpr int Cell::Offset[4];
+constexpr int Cell::Join[19];
+constexpr unsigned int Cell::PromotionRank[2];
 
-Cell::StaticTable::StaticTable() {
-	int offset[4] = {+7, +9, -7, -9};
-	for (int i = 0; i < 64; ++ i) {
-		Cell from = fromValue(i);
-		if (from.valid()) {
-			for (int j = 0; j < 4; ++ j) {
-				Cell to = fromValue(i+offset[j]);
-				if (to.valid())
-					neighbour[from.index()].push_back(to);
-			}
-			neighbour[from.index()].push_back(Cell());
-		}
-	}
-	for (int i = 0; i < 33; ++ i)
-		everything.push_back(fromIndex(i));
+namespace {
+
+// k-й по порядку направлений сосед поля from, начиная с направления 4+d; пустое поле, если их меньше.
+constexpr Cell nearby(Cell from, int k, int d = 0) {
+	return d == 4 ? Cell() :
+	       !from.neighbour(4+d).valid() ? nearby(from, k, d+1) :
+	       k == 0 ? from.neighbour(4+d) : nearby(from, k-1, d+1);
 }
 
-Cell Cell::fromValue(unsigned int value) {return Cell(value%8, value/8);}
-unsigned int Cell::index() const {return _value/2;}
-unsigned int Cell::value() const {return _value;}
-unsigned int Cell::file() const {return _value%8;}
-unsigned int Cell::rank() const {return _value/8;}
+constexpr std::uint8_t degree(Cell from) {
+	return 1 + from.neighbour(4).valid() + from.neighbour(5).valid() + from.neighbour(6).valid()
+	       + from.neighbour(7).valid();
+}
 
-Cell Cell::fromIndex(unsigned int index) {
-	Cell cell;
-	if (index < 32)
-		cell._value = index*2 + (index/4)%2;
-	return cell;
 }
 
+#define BOARD_CELLS(F) F(0) F(1) F(2) F(3) F(4) F(5) F(6) F(7) F(8) F(9) F(10) F(11) F(12) F(13) F(14) F(15) \
+	F(16) F(17) F(18) F(19) F(20) F(21) F(22) F(23) F(24) F(25) F(26) F(27) F(28) F(29) F(30) F(31)
+#define NEIGHBOURS(i) {nearby(fromIndex(i), 0), nearby(fromIndex(i), 1), nearby(fromIndex(i), 2), \
+	nearby(fromIndex(i), 3), Cell()},
+#define DEGREE(i) degree(fromIndex(i)),
+#define CELL(i) fromIndex(i),
+
+const Cell Cell::_neighbours[32][5] = {BOARD_CELLS(NEIGHBOURS)};
+const std::uint8_t Cell::_degree[32] = {BOARD_CELLS(DEGREE)};
+const Cell Cell::_everything[33] = {BOARD_CELLS(CELL) Cell()};
+
+#undef BOARD_CELLS
+#undef NEIGHBOURS
+#undef DEGREE
+#undef CELL
+
+static_assert(Cell(0, 0).neighbour(Direction::RightForward) == Cell(1, 1)
+              && !Cell(0, 0).neighbour(Direction::LeftForward).valid()
+              && Cell(1, 1).connection(Cell(0, 2)) == Direction::LeftForward
+              && Cell(1, 7).promotion(Role::White) && degree(Cell(0, 0)) == 2,
+              "Cell must fold at compile time");
+
 Cell Cell::fromString(std::string str) {
 	if (str.size() != 2)
 		return Cell();
@@ -56,54 +66,8 @@ std::string Cell::str() const {
 	return result;
 }
 
-Cell::Cell() : _value(None), _capture(false) {}
-
-Cell::Cell(unsigned int file, unsigned int rank) : _capture(false) {
-	_value = rank*8 + file;
-	if (file >= 8)
-		_value = None;
-	if (rank >= 8)
-		_value = None;
-	if ((file+rank)%2)
-		_value = None;
-}
-
-bool Cell::valid() const {return _value != None;}
-bool Cell::capture() const {return _capture;}
-void Cell::setCapture(bool flag) {_capture = flag;}
-bool operator==(Cell fst, Cell snd) {return fst._value == snd._value;}
-bool operator!=(Cell fst, Cell snd) {return fst._value != snd._value;}
-
-bool Cell::promotion(Role color) const {
-	if (!valid())
-		return false;
-	switch (color) {
-	case Role::White: return _value >= 56;
-	case Role::Black: return _value < 8;
-	default: return false;
-	}
-}
-
-Cell Cell::neighbour(Direction direction) const {
-	switch (direction) {
-	case Direction::LeftForward: return Cell::fromValue(_value+7);
-	case Direction::RightForward: return Cell::fromValue(_value+9);
-	case Direction::LeftBackward: return Cell::fromValue(_value-9);
-	case Direction::RightBackward: return Cell::fromValue(_value-7);
-	default: return Cell::fromValue(None);
-	}
-}
-
-Direction Cell::connection(Cell other) const {
-    switch (static_cast<int>(other._value) - static_cast<int>( _value)) {
-	case +7: return Direction::LeftForward;
-	case +9: return Direction::RightForward;
-	case -9: return Direction::LeftBackward;
-	case -7: return Direction::RightBackward;
-	default: return Direction::None;
-	}
-}
+void Cell::setCapture(bool flag) {_value = flag ? _value | CaptureFlag : _value & ~CaptureFlag;}
 
-const std::vector<Cell>& Cell::neighbours(Cell from) {
-	return from.valid() ? _table.neighbour[from.index()] : _table.everything;
+Span<Cell> Cell::neighbours(Cell from) {
+	return from.valid() ? Span<Cell>(_neighbours[from.index()], _degree[from.index()]) : Span<Cell>(_everything);
 }
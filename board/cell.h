@@ -4,42 +4,61 @@
 // Поле на шашечной доске.
 
 #include "direction.h"
+#include "span.h"
+#include <cstdint>
 #include <string>
 
 class Cell {
 public:
-	Cell ();
-	Cell (unsigned int file, unsigned int rank);
-	static Cell fromIndex (unsigned int index);
-	static Cell fromValue (unsigned int value);
+	constexpr Cell () : _value(None) {}
+	constexpr Cell (unsigned int file, unsigned int rank)
+		: _value(file < 8 && rank < 8 && (file+rank)%2 == 0 ? rank*8 + file : None) {}
+	static constexpr Cell fromIndex (unsigned int index) {
+		return index < 32 ? fromValue(index*2 + (index/4)%2) : Cell();
+	}
+	static constexpr Cell fromValue (unsigned int value) {return Cell(value%8, value/8);}
 	static Cell fromString (std::string str);
-	unsigned int index () const;
-	unsigned int value () const;
-	unsigned int file () const;
-	unsigned int rank () const;
+	constexpr unsigned int index () const {return value()/2;}
+	constexpr unsigned int value () const {return _value & ~CaptureFlag;}
+	constexpr unsigned int file () const {return value()%8;}
+	constexpr unsigned int rank () const {return value()/8;}
 	std::string str() const;
 public:
-	bool valid () const;
-	bool capture () const;
-	bool promotion (Role color) const;
-	Cell neighbour (Direction direction) const;
-	Direction connection (Cell other) const;
+	constexpr bool valid () const {return value() != None;}
+	constexpr bool capture () const {return (_value & CaptureFlag) != 0;}
+	constexpr bool promotion (Role color) const {
+		return valid() && color.valid() && rank() == PromotionRank[color];
+	}
+	constexpr Cell neighbour (Direction direction) const {
+		return valid() && direction.valid() ? step(static_cast<int>(value()) + Offset[direction - Direction::LeftForward]) : Cell();
+	}
+	constexpr Direction connection (Cell other) const {
+		return join(static_cast<int>(other.value()) - static_cast<int>(value()));
+	}
 	void setCapture (bool flag);
-	static const std::vector<Cell>& neighbours (Cell from = Cell());
+	static Span<Cell> neighbours (Cell from = Cell());    // Соседние поля и пустое; для пустого — все поля.
 public:
-	static const unsigned int None;
-	friend bool operator== (Cell fst, Cell snd);
-	friend bool operator!= (Cell fst, Cell snd);
+	static const unsigned int None = 80;
+	friend constexpr bool operator== (Cell fst, Cell snd) {return fst.value() == snd.value();}
+	friend constexpr bool operator!= (Cell fst, Cell snd) {return fst.value() != snd.value();}
 private:
-	unsigned int _value;
-	bool _capture;
+	static const std::uint8_t CaptureFlag = 0x80;
+	std::uint8_t _value;    // Номер поля 0..63 или None; старший бит — признак взятия.
 private:
-	struct StaticTable {
-		std::vector<Cell> neighbour[32];
-		std::vector<Cell> everything;
-		StaticTable ();
-	};
-	static const StaticTable _table;
+	static constexpr int Offset[4] = {+7, +9, -7, -9};       // Сдвиг номера поля по направлению.
+	static constexpr int Join[19] = {                        // Направление по разности номеров полей плюс 9.
+		Direction::LeftBackward, Direction::None, Direction::RightBackward, Direction::None, Direction::None,
+		Direction::None, Direction::None, Direction::None, Direction::None, Direction::None, Direction::None,
+		Direction::None, Direction::None, Direction::None, Direction::None, Direction::None,
+		Direction::LeftForward, Direction::None, Direction::RightForward};
+	static constexpr unsigned int PromotionRank[2] = {7, 0};    // Горизонталь превращения белых и чёрных.
+	static constexpr Cell step (int value) {return value >= 0 && value < 64 ? fromValue(value) : Cell();}
+	static constexpr Direction join (int difference) {
+		return difference >= -9 && difference <= 9 ? Join[difference + 9] : Direction::None;
+	}
+	static const Cell _neighbours[32][5];    // Соседи поля, затем пустое поле.
+	static const std::uint8_t _degree[32];   // Длина строки _neighbours.
+	static const Cell _everything[33];       // Все поля, затем пустое поле.
 };
 
 #endif
@@ -0,0 +1,84 @@
+#include "clock.h"
+#include <algorithm>
+#include <cstdlib>
+
+Clock::Clock () : _base(0.0), _increment(0.0), _period(0), _moves(0), _left(0.0), _running(false) {}
+
+bool Clock::parse (const std::string &control, Clock &clock) {
+	Clock result;
+	const char *p = control.c_str();
+	char *end;
+	double first = std::strtod(p, &end);
+	if (end == p)
+		return false;
+	if (*end == '/') {
+		result._period = static_cast<int>(first);
+		if (result._period <= 0 || result._period != first)
+			return false;
+		p = end+1;
+		first = std::strtod(p, &end);
+		if (end == p)
+			return false;
+	}
+	result._base = first;
+	if (*end == '+') {
+		p = end+1;
+		result._increment = std::strtod(p, &end);
+		if (end == p)
+			return false;
+	}
+	if (*end || result._base <= 0.0 || result._increment < 0.0)
+		return false;
+	result._left = result._base;
+	clock = result;
+	return true;
+}
+
+bool Clock::enabled () const {return _base > 0.0;}
+
+void Clock::start () {
+	_started = std::chrono::steady_clock::now();
+	_running = true;
+}
+
+bool Clock::stop () {
+	if (!_running)
+		return !flagged();
+	_left = remaining();
+	_running = false;
+	if (!enabled())
+		return true;
+	if (_left <= 0.0)
+		return false;
+	_left += _increment;
+	if (_period && ++ _moves == _period) {
+		_moves = 0;
+		_left += _base;
+	}
+	return true;
+}
+
+void Clock::pause () {
+	if (!_running)
+		return;
+	_left = remaining();
+	_running = false;
+}
+
+bool Clock::running () const {return _running;}
+
+double Clock::remaining () const {
+	if (!_running)
+		return _left;
+	return _left - std::chrono::duration<double>(std::chrono::steady_clock::now() - _started).count();
+}
+
+bool Clock::flagged () const {return enabled() && remaining() <= 0.0;}
+
+void Clock::limit (Limits &limits) const {
+	if (!enabled())
+		return;
+	limits.clock = std::max(remaining(), 1e-3);
+	limits.increment = _increment;
+	limits.moves = _period ? _period - _moves : 0;
+}
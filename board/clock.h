@@ -0,0 +1,37 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "minimax.h"
+#include <chrono>
+#include <string>
+
+/*
+ * Шахматные часы одного игрока. Контроль времени записывается как
+ * "300" (5 минут на партию), "300+2" (и 2 секунды добавки за ход)
+ * или "40/600" (600 секунд на каждые 40 ходов, остаток переходит
+ * в следующий период). Часы без контроля времени не ограничивают.
+ */
+
+class Clock {
+public:
+	Clock ();
+	static bool parse (const std::string &control, Clock &clock);
+	bool enabled () const;
+	void start ();               // Игрок начал думать над ходом.
+	bool stop ();                // Ход сделан; false, если время вышло раньше.
+	void pause ();               // Ход не сделан, но время пока не идёт.
+	bool running () const;
+	double remaining () const;   // Остаток в секундах, с учётом идущего хода.
+	bool flagged () const;
+	void limit (Limits &limits) const;    // Передать остаток поиску.
+private:
+	double _base;         // Время на партию или на период.
+	double _increment;
+	int _period;          // Ходов в периоде; 0 — вся партия.
+	int _moves;           // Сделано ходов в текущем периоде.
+	double _left;         // Остаток до начала текущего хода.
+	bool _running;
+	std::chrono::steady_clock::time_point _started;
+};
+
+#endif
@@ -1,8 +1,8 @@
 #ifndef DIRECTION_H
 #define DIRECTION_H
 
-#include <vector>
 #include "role.h"
+#include "span.h"
 
 // Направление движения по шашечной доске. Пассивные данные.
 
@@ -15,21 +15,29 @@ public:
 		static const int GoStraight = 0;
 		static const int GoRight = 1;
 		static const int GoOpposite = 2;
-		Turn (int v) : _value((v >= -2 && v <=2) ? v : None) {}
-		operator int () {return _value;}
+		constexpr Turn (int v) : _value((v >= -2 && v <=2) ? v : None) {}
+		constexpr operator int () const {return _value;}
 	private:
 		int _value;
 	};
 public:
-	Direction ();
-	Direction (int index);
-	operator int () const;
-	Direction opposite () const;
-	Turn derivator (Direction target) const;
-	Direction derive (Turn turn) const;
-	bool valid (Role color = Role::None) const;
+	constexpr Direction () : _value(None) {}
+	constexpr Direction (int index) : _value(index >= 4 && index < 8 ? index : None) {}
+	constexpr operator int () const {return _value;}
+	// Противоположные направления отличаются вторым битом.
+	constexpr Direction opposite () const {return _value == None ? None : _value ^ 2;}
+	constexpr Turn derivator (Direction target) const {
+		return _value == None || target._value == None ? Turn::None : Turns[(target._value - _value) & 3];
+	}
+	constexpr Direction derive (Turn turn) const {
+		return _value == None || turn == Turn::None || turn == Turn::GoOpposite ? None : 4 + ((_value + turn) & 3);
+	}
+	constexpr bool valid (Role color = Role::None) const {
+		return color == Role::White ? _value == LeftForward || _value == RightForward :
+		       color == Role::Black ? _value == LeftBackward || _value == RightBackward : _value != None;
+	}
 public:
-	static const std::vector<Direction>& enumerate ();
+	static Span<Direction> enumerate ();
 	static const int LeftForward = 4;
 	static const int RightForward = 5;
 	static const int RightBackward = 6;
@@ -38,11 +46,11 @@ public:
 private:
 	int _value;
 private:
-	struct StaticTable {
-		std::vector<Direction> everything;
-		StaticTable ();
-	};
-	static const StaticTable _table;
+	// Поворот к направлению, следующему через столько-то четвертей круга по часовой стрелке.
+	static constexpr int Turns[4] = {Turn::GoStraight, Turn::GoRight, Turn::GoOpposite, Turn::GoLeft};
+	static const Direction _everything[4];
 };
 
+inline Span<Direction> Direction::enumerate () {return Span<Direction>(_everything);}
+
 #endif
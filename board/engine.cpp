@@ -0,0 +1,822 @@
+#include "engine.h"
+#include "history.h"
+#include "network.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const int MaxLevel = 7;            // Глубина поиска по умолчанию за вычетом первого полухода.
+const int MaxDepth = 64;           // Предел итеративного углубления.
+const int Plies = 128;             // Столько полуходов от корня помнят ходы-убийцы.
+const std::uint8_t NoMove = 255;   // Вместо номера поля: хода нет.
+const double Draw = 1.0;           // Оценка ничьей: силы равны.
+const double Overhead = 0.05;      // Запас на часах в секундах на передачу хода.
+const int Horizon = 25;            // Столько ходов ещё ожидается, если контроль до конца партии.
+
+struct Interrupted {};    // Исключение: поиск прерван по ограничению.
+
+/*
+ * Счёт узлов и проверка ограничений поиска. Пока идёт обдумывание на
+ * времени соперника, действует только остановка; с попаданием время
+ * отсчитывается заново, а итерация глубже заданной прерывается.
+ */
+class Control {
+public:
+	Control (const Limits &limits, std::atomic<unsigned long long> &shared)
+		: _limits(limits), _start(std::chrono::steady_clock::now()), _nodes(0), _shared(shared), _armed(false),
+		  _pondering(limits.ponder && limits.ponder->load()), _beyond(false) {
+		_shared.store(0, std::memory_order_relaxed);
+	}
+	void arm () {_armed = true;}    // До первого вызова ограничения не действуют.
+	void deepen (bool beyond) {_beyond = beyond;}    // Итерация нужна, только пока идёт обдумывание.
+	void visit () {
+		++ _nodes;
+		if (_nodes % 1024 == 0)
+			_shared.store(_nodes, std::memory_order_relaxed);
+		if (!_armed)
+			return;
+		if (_pondering) {
+			if (_nodes % 1024 != 0)
+				return;
+			if (_limits.stop && _limits.stop->load())
+				throw Interrupted();
+			if (pondering())
+				return;
+		}
+		if (_beyond || (_limits.nodes && _nodes >= _limits.nodes))
+			throw Interrupted();
+		if (_nodes % 1024 == 0 && ((_limits.stop && _limits.stop->load()) ||
+		                           (_limits.time > 0.0 && elapsed() >= _limits.time)))
+			throw Interrupted();
+	}
+	bool pondering () {
+		if (_pondering && !_limits.ponder->load()) {
+			_pondering = false;
+			_start = std::chrono::steady_clock::now();
+		}
+		return _pondering;
+	}
+	unsigned long long nodes () const {return _nodes;}
+	double elapsed () const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+	}
+	bool expired () {
+		if (pondering())
+			return _limits.stop && _limits.stop->load();
+		return (_limits.stop && _limits.stop->load()) || (_limits.time > 0.0 && elapsed() >= _limits.time)
+		       || (_limits.nodes && _nodes >= _limits.nodes);
+	}
+private:
+	const Limits &_limits;
+	std::chrono::steady_clock::time_point _start;
+	unsigned long long _nodes;
+	std::atomic<unsigned long long> &_shared;    // Копия счётчика для других потоков.
+	bool _armed;
+	bool _pondering;    // Ход соперника ещё не сделан.
+	bool _beyond;
+};
+
+/*
+ * Время хода по часам. Обычная доля — остаток, делённый на ожидаемое
+ * число ходов, плюс большая часть добавки. Доля растёт, пока лучший ход
+ * меняется от итерации к итерации и когда оценка падает для ходящего,
+ * но жёсткий предел не превышается никогда: он оставляет на часах
+ * не меньше половины остатка (на последнем ходу периода — десятой части).
+ * Новая итерация не начинается, если она скорее всего не успеет.
+ */
+class Budget {
+public:
+	Budget (const Limits &limits) : _target(0.0), _hard(0.0), _instability(0.0), _score(0.0) {
+		if (limits.clock <= 0.0)
+			return;
+		double left = std::max(0.0, limits.clock - Overhead);
+		int moves = limits.moves > 0 ? std::min(limits.moves, Horizon) : Horizon;
+		_hard = std::max(1e-3, std::min(left * (moves == 1 ? 0.9 : 0.5), (left/moves + limits.increment) * 4.0));
+		_target = std::min(_hard, left/moves + 0.75*limits.increment);
+	}
+	double hard () const {return _hard;}    // 0 — часов нет.
+	bool enough (double elapsed, const Variation &best, Role color) {
+		if (_hard <= 0.0)
+			return false;
+		bool changed = !_best.empty() && _best != best.action;
+		bool dropped = !_best.empty() && (color == Role::White ? best.score < _score/1.1 : best.score > _score*1.1);
+		_instability = _instability/2.0 + changed;
+		_best = best.action;
+		_score = best.score;
+		double share = _target * (1.0 + _instability/2.0) * (dropped ? 1.5 : 1.0);
+		return elapsed >= std::min(share, _hard) * 0.6;
+	}
+private:
+	double _target, _hard;
+	double _instability;          // Затухающая сумма смен лучшего хода.
+	std::vector<Cell> _best;      // Лучший ход и оценка предыдущей итерации.
+	double _score;
+};
+
+// Оценка листьев: сетью с накопителем, обновляемым от хода к ходу, или evaluate().
+struct Leaf {
+	const Network *network;
+	Network::Accumulator accumulator;
+	Leaf (const Network *n, const BoardState &board) : network(n) {
+		if (network)
+			network->refresh(board.position(), accumulator);
+	}
+	Leaf (const Leaf &parent, const BoardState &from, const BoardState &to) : network(parent.network) {
+		if (network)
+			network->update(parent.accumulator, from.position(), to.position(), accumulator);
+	}
+	double evaluate (const BoardState &board) const {
+		return network ? network->evaluate(board, accumulator) : ::evaluate(board);
+	}
+};
+
+// Ключ позиции после полного хода, когда на доске нет призраков.
+std::uint64_t hash (const BoardState &board) {return History::key(board);}
+
+// Ход в таблицах упорядочения: начальное и конечное поля, а у взятия ещё
+// и свёртка маски взятых шашек, по которой различаются взятия с одними полями.
+struct Motion {
+	std::uint8_t from, to;
+	std::uint8_t taken;    // 0 у тихого хода.
+};
+
+const Motion Nowhere = {NoMove, NoMove, 0};
+
+bool operator== (Motion m1, Motion m2) {return m1.from == m2.from && m1.to == m2.to && m1.taken == m2.taken;}
+
+Motion motion (const BoardState &board, const std::vector<Cell> &action) {
+	Motion m;
+	m.from = action.front().index();
+	m.to = action[action.size()-2].index();
+	Role enemy = board.color().opposite();
+	std::uint32_t taken = 0;
+	for (std::size_t i = 1; i+1 < action.size(); ++ i)
+		if (board.position().color(action[i]) == enemy)
+			taken |= 1u << action[i].index();
+	m.taken = taken ? static_cast<std::uint8_t>((taken * 0x9E3779B1u) >> 24 | 1) : 0;
+	return m;
+}
+
+using Line = std::vector<std::vector<Cell>>;
+
+/*
+ * Ходы узла по одному, по мере надобности. Взятия обязательны, поэтому
+ * при них строятся сразу все ходы (distinct) и упорядочиваются: ход из
+ * таблицы, ходы-убийцы, затем по истории. Без взятий ход из таблицы
+ * и ходы-убийцы проверяются прямо по доске, а остальные тихие ходы
+ * строятся, только когда до них дойдёт очередь; в узле, где отсекает
+ * первый же ход, полного списка ходов не бывает.
+ */
+class Picker {
+public:
+	Picker (const BoardState &board, Motion hint, const Motion *killers, const std::int32_t (*history)[32])
+		: _board(board), _history(history), _stage(Hint), _tried(0), _next(0) {
+		_first[0] = hint;
+		_first[1] = killers ? killers[0] : Nowhere;
+		_first[2] = killers ? killers[1] : Nowhere;
+		if (!board.quiet())
+			generate();
+	}
+	const std::vector<Cell>* next () {    // nullptr, когда ходы кончились.
+		while (_stage < Rest) {
+			Motion m = _first[_stage ++];
+			bool repeated = std::find(_done, _done + _tried, m) != _done + _tried;
+			if (!repeated && build(m)) {
+				_done[_tried ++] = m;
+				return &_action;
+			}
+		}
+		if (_stage == Rest)
+			generate();
+		return _next < _order.size() ? &_every[_order[_next ++]] : nullptr;
+	}
+private:
+	enum Stage {Hint, Killer, Second, Rest, Done};
+	bool build (Motion m);
+	void generate ();
+private:
+	const BoardState &_board;
+	const std::int32_t (*_history)[32];
+	int _stage;
+	Motion _first[3];                  // Ход из таблицы и ходы-убийцы.
+	Motion _done[3];                   // Из них уже отданные.
+	int _tried;
+	std::vector<Cell> _action;
+	std::vector<std::vector<Cell>> _every;
+	std::vector<unsigned int> _order;
+	std::size_t _next;
+};
+
+// Тихий ход m, если он возможен: простая идёт на соседнее поле вперёд, дамка — по свободной диагонали.
+bool Picker::build (Motion m) {
+	if (m.from >= 32 || m.to >= 32)
+		return false;
+	const Position &position = _board.position();
+	Role color = _board.color();
+	Cell from = Cell::fromIndex(m.from), to = Cell::fromIndex(m.to);
+	if (position.color(from) != color)
+		return false;
+	bool king = position.king(from);
+	for (Direction direction : Direction::enumerate()) {
+		if (!king && !direction.valid(color))
+			continue;
+		_action.assign(1, from);
+		for (Cell cell = from.neighbour(direction); cell.valid() && !position.color(cell).valid();
+		     cell = cell.neighbour(direction)) {
+			_action.push_back(cell);
+			if (cell == to) {
+				_action.push_back(Cell());
+				return true;
+			}
+			if (!king)
+				break;
+		}
+	}
+	return false;
+}
+
+// Остальные ходы: сначала ход из таблицы и ходы-убийцы, затем по истории; при равенстве — как в distinct().
+void Picker::generate () {
+	const int Killer = 1 << 30;
+	_stage = Done;
+	_every = distinct(_board);
+	std::vector<std::int32_t> keys(_every.size());
+	for (std::size_t i = 0; i < _every.size(); ++ i) {
+		Motion m = motion(_board, _every[i]);
+		if (std::find(_done, _done + _tried, m) != _done + _tried)
+			continue;
+		_order.push_back(i);
+		if (m == _first[0])
+			keys[i] = Killer + 2;
+		else if (m == _first[1])
+			keys[i] = Killer + 1;
+		else if (m == _first[2])
+			keys[i] = Killer;
+		else
+			keys[i] = _history[m.from][m.to];
+	}
+	std::stable_sort(_order.begin(), _order.end(), [&keys](unsigned int a, unsigned int b) {
+		return keys[a] > keys[b];
+	});
+}
+
+// Продолжение pv после хода action — это action и продолжение child.
+void extend (Line *pv, const std::vector<Cell> &action, const Line &child) {
+	pv->assign(1, action);
+	pv->insert(pv->end(), child.begin(), child.end());
+}
+
+}
+
+/*
+ * Запись таблицы читается и пишется без блокировок: первое слово — ключ,
+ * сложенный по модулю 2 с остальными словами, поэтому запись, наполовину
+ * переписанная другим потоком, не совпадёт ни с каким ключом.
+ */
+struct Engine::Entry {
+	std::atomic<std::uint64_t> check;
+	std::atomic<std::uint64_t> score;    // Биты double.
+	std::atomic<std::uint64_t> data;     // Глубина, вид оценки, поля лучшего хода, поколение, взятые шашки.
+};
+
+class Engine::Table {
+public:
+	enum Bound {Exact = 1, Lower, Upper};    // Оценка точная, не меньше или не больше.
+	struct Probe {
+		double score;
+		int depth;
+		Bound bound;
+		Motion move;          // Лучший ход или Nowhere.
+	};
+	Table (std::size_t megabytes) : _size(1), _age(0) {
+		std::size_t count = megabytes * 1024 * 1024 / sizeof(Entry);
+		while (_size * 2 <= count)
+			_size *= 2;
+		_entries.reset(new Entry[_size]);
+		clear();
+	}
+	void clear () {
+		for (std::size_t i = 0; i < _size; ++ i) {
+			_entries[i].check.store(0, std::memory_order_relaxed);
+			_entries[i].score.store(0, std::memory_order_relaxed);
+			_entries[i].data.store(0, std::memory_order_relaxed);
+		}
+	}
+	void age () {++ _age;}
+	bool probe (std::uint64_t key, Probe &probe) const {
+		const Entry &entry = _entries[key & (_size-1)];
+		std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+		std::uint64_t score = entry.score.load(std::memory_order_relaxed);
+		std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+		if (!(data & Valid) || (check ^ score ^ data) != key)
+			return false;
+		std::memcpy(&probe.score, &score, sizeof score);
+		probe.depth = data & 0xFF;
+		probe.bound = static_cast<Bound>((data >> 8) & 0xFF);
+		probe.move.from = (data >> 16) & 0xFF;
+		probe.move.to = (data >> 24) & 0xFF;
+		probe.move.taken = (data >> 48) & 0xFF;
+		return true;
+	}
+	void store (std::uint64_t key, int depth, Bound bound, double value, Motion move) {
+		Entry &entry = _entries[key & (_size-1)];
+		std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+		std::uint64_t score = entry.score.load(std::memory_order_relaxed);
+		std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+		bool same = (check ^ score ^ data) == key;
+		// Более глубокую запись текущего поиска о другой позиции не вытесняем.
+		if ((data & Valid) && !same && ((data >> 32) & 0xFF) == _age && static_cast<int>(data & 0xFF) > depth)
+			return;
+		std::uint64_t best = move.from == NoMove && same ? data & 0xFF0000FFFF0000ull :
+		                     static_cast<std::uint64_t>(move.taken) << 48 | static_cast<std::uint64_t>(move.to) << 24
+		                     | static_cast<std::uint64_t>(move.from) << 16;
+		std::memcpy(&score, &value, sizeof score);
+		data = Valid | static_cast<std::uint64_t>(_age) << 32 | best
+		       | static_cast<std::uint64_t>(bound) << 8 | static_cast<std::uint64_t>(std::min(depth, 255));
+		entry.check.store(key ^ score ^ data, std::memory_order_relaxed);
+		entry.score.store(score, std::memory_order_relaxed);
+		entry.data.store(data, std::memory_order_relaxed);
+	}
+private:
+	static const std::uint64_t Valid = 1ull << 40;
+	std::unique_ptr<Entry[]> _entries;
+	std::size_t _size;
+	std::uint8_t _age;    // Номер поиска; записи прошлых поисков вытесняются первыми.
+};
+
+// Сведения для упорядочения ходов, свои у каждого потока.
+struct Engine::Worker {
+	Motion killers[Plies][2];        // Последние ходы, вызвавшие отсечение на этом полуходе.
+	std::int32_t history[2][32][32];    // Вклад хода в отсечения: [цвет][откуда][куда].
+	std::atomic<unsigned long long> nodes;
+	Worker () : nodes(0) {clear();}
+	void clear () {
+		std::fill(&killers[0][0], &killers[0][0] + Plies*2, Nowhere);
+		std::memset(history, 0, sizeof history);
+	}
+	void age () {    // Сведения прошлых поисков весят вдвое меньше.
+		for (auto &color : history)
+			for (auto &from : color)
+				for (std::int32_t &value : from)
+					value /= 2;
+	}
+};
+
+class Engine::Search {
+public:
+	Search (Table *table, Worker &worker, Control &control, const Network *network)
+		: _table(table), _worker(worker), _control(control), _network(network), _root(0), _run(0) {}
+	void trace (const History *history, const BoardState &root);
+	std::vector<Variation> rank (const BoardState &board, const std::vector<std::vector<Cell>> &actions,
+	                             int count, int level, bool lines);
+private:
+	double white (const BoardState &board, const Leaf &leaf, int level, int ply, int run,
+	              double alpha, double beta, Line *pv);
+	double black (const BoardState &board, const Leaf &leaf, int level, int ply, int run,
+	              double alpha, double beta, Line *pv);
+	bool drawn (std::uint64_t key, int run) const;
+	bool probe (std::uint64_t key, int depth, double alpha, double beta, double &score, Motion &hint) const;
+	void store (std::uint64_t key, int depth, Table::Bound bound, double score, Motion move);
+	void reward (const BoardState &board, const std::vector<Cell> &action, int ply, int depth);
+	void follow (BoardState board, int depth, Line *pv) const;
+private:
+	Table *_table;
+	Worker &_worker;
+	Control &_control;
+	const Network *_network;
+	std::vector<std::uint64_t> _keys;    // Позиции партии и пути от корня до текущей, без неё.
+	std::size_t _root;                   // Номер корня в _keys.
+	int _run;                            // Обратимых полуходов подряд до корня.
+};
+
+// Позиция на время обхода её потомков лежит на пути.
+class Visit {
+public:
+	Visit (std::vector<std::uint64_t> &keys, std::uint64_t key) : _keys(keys) {_keys.push_back(key);}
+	~Visit () {_keys.pop_back();}
+private:
+	std::vector<std::uint64_t> &_keys;
+};
+
+bool Engine::Search::probe (std::uint64_t key, int depth, double alpha, double beta,
+                            double &score, Motion &hint) const {
+	Table::Probe entry;
+	if (!_table || !_table->probe(key, entry))
+		return false;
+	hint = entry.move;
+	if (entry.depth < depth)
+		return false;
+	score = entry.score;
+	return entry.bound == Table::Exact || (entry.bound == Table::Lower && score > beta)
+	       || (entry.bound == Table::Upper && score < alpha);
+}
+
+void Engine::Search::store (std::uint64_t key, int depth, Table::Bound bound, double score, Motion move) {
+	if (_table)
+		_table->store(key, depth, bound, score, move);
+}
+
+void Engine::Search::reward (const BoardState &board, const std::vector<Cell> &action, int ply, int depth) {
+	Motion m = motion(board, action);
+	if (ply < Plies) {
+		Motion *killers = _worker.killers[ply];
+		if (!(killers[0] == m)) {
+			killers[1] = killers[0];
+			killers[0] = m;
+		}
+	}
+	std::int32_t &value = _worker.history[board.color()][m.from][m.to];
+	value += (depth+1) * (depth+1);
+	if (value > (1 << 24))
+		_worker.age();
+}
+
+// Главное продолжение по лучшим ходам из таблицы, если поиск взял оценку оттуда.
+void Engine::Search::follow (BoardState board, int depth, Line *pv) const {
+	if (!pv || !_table)
+		return;
+	for (int i = 0; i <= depth; ++ i) {
+		Table::Probe entry;
+		if (!_table->probe(hash(board), entry) || entry.move.from == NoMove)
+			return;
+		Picker picker(board, entry.move, nullptr, _worker.history[board.color()]);
+		const std::vector<Cell> *action = picker.next();
+		if (!action || !(motion(board, *action) == entry.move))
+			return;
+		pv->push_back(*action);
+		BoardState::apply(board, *action);
+	}
+}
+
+double Engine::Search::white (const BoardState &board, const Leaf &leaf, int level, int ply, int run,
+                              double alpha, double beta, Line *pv) {
+	_control.visit();
+	if (pv)
+		pv->clear();
+	if (level <= 0 && board.quiet())
+		return leaf.evaluate(board);
+	int depth = std::max(level, 0);
+	std::uint64_t key = hash(board);
+	if (drawn(key, run))
+		return Draw;
+	Motion hint = Nowhere;
+	double stored;
+	if (probe(key, depth, alpha, beta, stored, hint)) {
+		follow(board, depth, pv);
+		return stored;
+	}
+	Picker picker(board, hint, ply < Plies ? _worker.killers[ply] : nullptr, _worker.history[board.color()]);
+	const std::vector<Cell> *action = picker.next();
+	if (!action)
+		return BlackWin;
+	double result = BlackWin / 2.0, origin = alpha;
+	Motion best = Nowhere;
+	Line line;
+	Visit visit(_keys, key);
+	for (; action; action = picker.next()) {
+		BoardState copy = board;
+		BoardState::apply(copy, *action);
+		int next = History::reversible(board, *action) ? run+1 : 0;
+		double value = black(copy, Leaf(leaf, board, copy), level-1, ply+1, next, alpha, beta, pv ? &line : nullptr);
+		if (value > beta) {
+			reward(board, *action, ply, depth);
+			store(key, depth, Table::Lower, value, motion(board, *action));
+			return value;
+		}
+		if (value > alpha)
+			alpha = value;
+		if (value > result) {
+			result = value;
+			best = motion(board, *action);
+			if (pv)
+				extend(pv, *action, line);
+		}
+	}
+	store(key, depth, result <= origin ? Table::Upper : result >= beta ? Table::Lower : Table::Exact, result, best);
+	return result;
+}
+
+double Engine::Search::black (const BoardState &board, const Leaf &leaf, int level, int ply, int run,
+                              double alpha, double beta, Line *pv) {
+	_control.visit();
+	if (pv)
+		pv->clear();
+	if (level <= 0 && board.quiet())
+		return leaf.evaluate(board);
+	int depth = std::max(level, 0);
+	std::uint64_t key = hash(board);
+	if (drawn(key, run))
+		return Draw;
+	Motion hint = Nowhere;
+	double stored;
+	if (probe(key, depth, alpha, beta, stored, hint)) {
+		follow(board, depth, pv);
+		return stored;
+	}
+	Picker picker(board, hint, ply < Plies ? _worker.killers[ply] : nullptr, _worker.history[board.color()]);
+	const std::vector<Cell> *action = picker.next();
+	if (!action)
+		return WhiteWin;
+	double result = WhiteWin * 2.0, origin = beta;
+	Motion best = Nowhere;
+	Line line;
+	Visit visit(_keys, key);
+	for (; action; action = picker.next()) {
+		BoardState copy = board;
+		BoardState::apply(copy, *action);
+		int next = History::reversible(board, *action) ? run+1 : 0;
+		double value = white(copy, Leaf(leaf, board, copy), level-1, ply+1, next, alpha, beta, pv ? &line : nullptr);
+		if (value < alpha) {
+			reward(board, *action, ply, depth);
+			store(key, depth, Table::Upper, value, motion(board, *action));
+			return value;
+		}
+		if (value < beta)
+			beta = value;
+		if (value < result) {
+			result = value;
+			best = motion(board, *action);
+			if (pv)
+				extend(pv, *action, line);
+		}
+	}
+	store(key, depth, result >= origin ? Table::Lower : result <= alpha ? Table::Upper : Table::Exact, result, best);
+	return result;
+}
+
+// Позиции партии до корня, среди которых могут найтись повторения.
+void Engine::Search::trace (const History *history, const BoardState &root) {
+	_keys.clear();
+	_run = 0;
+	if (history && !history->keys().empty() && history->keys().back() == hash(root)) {
+		_run = history->run();
+		const std::vector<std::uint64_t> &keys = history->keys();
+		_keys.assign(keys.end()-1 - _run, keys.end()-1);
+	}
+	_root = _keys.size();
+}
+
+/*
+ * Ничья по правилам (см. History): обратимых полуходов подряд слишком
+ * много или позиция уже встречалась. Повторение в пределах поиска
+ * считается ничьей сразу, иначе из него можно кружить без конца;
+ * в партии до корня позиция должна встретиться дважды.
+ */
+bool Engine::Search::drawn (std::uint64_t key, int run) const {
+	if (run >= History::KingPlies)
+		return true;
+	int seen = 0;
+	for (int back = 2; back <= run && back <= static_cast<int>(_keys.size()); back += 2) {
+		std::size_t i = _keys.size() - back;
+		if (_keys[i] == key && (i >= _root || ++ seen == 2))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Поиск в корне сразу для count лучших ходов. Каждый следующий ход ищется
+ * с границей, равной оценке count-го из уже найденных лучших ходов: ход,
+ * не превзошедший её, в число лучших не входит, и его точная оценка не нужна.
+ * Пока лучших ходов найдено меньше count, окно поиска полное. При count = 1
+ * это обычный поиск с сужением окна в корне.
+ */
+std::vector<Variation> Engine::Search::rank (const BoardState &board, const std::vector<std::vector<Cell>> &actions,
+                                             int count, int level, bool lines) {
+	std::vector<Variation> result;
+	Leaf leaf(_network, board);
+	Visit visit(_keys, hash(board));
+	bool isWhite = board.color() == Role::White;
+	auto better = [isWhite](const Variation &v1, const Variation &v2) {
+		return isWhite ? v1.score > v2.score : v1.score < v2.score;
+	};
+	for (const std::vector<Cell> &action : actions) {
+		BoardState copy = board;
+		BoardState::apply(copy, action);
+		bool full = static_cast<int>(result.size()) >= count;
+		int run = History::reversible(board, action) ? _run+1 : 0;
+		Variation variation;
+		variation.action = action;
+		Line line;
+		if (isWhite) {
+			double bound = full ? result.back().score : BlackWin;
+			variation.score = black(copy, Leaf(leaf, board, copy), level, 1, run, bound, WhiteWin,
+			                        lines ? &line : nullptr);
+			if (full && !(variation.score > bound))
+				continue;
+		}
+		else {
+			double bound = full ? result.back().score : WhiteWin;
+			variation.score = white(copy, Leaf(leaf, board, copy), level, 1, run, BlackWin, bound,
+			                        lines ? &line : nullptr);
+			if (full && !(variation.score < bound))
+				continue;
+		}
+		extend(&variation.line, action, line);
+		result.insert(std::upper_bound(result.begin(), result.end(), variation, better), variation);
+		if (static_cast<int>(result.size()) > count)
+			result.pop_back();
+	}
+	return result;
+}
+
+Engine::Engine (const Config &config)
+	: _job(0), _busy(0), _quit(false), _halt(false), _history(nullptr), _depth(0) {
+	configure(config);
+}
+
+Engine::~Engine () {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (std::thread &thread : _threads)
+		thread.join();
+}
+
+const Engine::Config& Engine::config () const {return _config;}
+
+void Engine::configure (const Config &config) {
+	std::lock_guard<std::mutex> running(_running);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (std::thread &thread : _threads)
+		thread.join();
+	_threads.clear();
+	_quit = false;
+	_config = config;
+	_config.threads = std::max(1u, config.threads);
+	_table.reset(_config.hash ? new Table(_config.hash) : nullptr);
+	_workers.clear();
+	for (unsigned int i = 0; i < _config.threads; ++ i)
+		_workers.emplace_back(new Worker);
+	for (unsigned int i = 1; i < _config.threads; ++ i)
+		_threads.emplace_back(&Engine::work, this, i);
+}
+
+void Engine::clear () {
+	if (_table)
+		_table->clear();
+	for (auto &worker : _workers)
+		worker->clear();
+}
+
+std::vector<Cell> Engine::search (const BoardState &board) {
+	return search(board, _config.limits);
+}
+
+std::vector<Cell> Engine::search (const BoardState &board, const Limits &limits, Report report) {
+	std::vector<std::vector<Cell>> actions = distinct(board);
+	if (actions.empty() || !board.color().valid())
+		return {};
+	if (actions.size() == 1 && !(limits.ponder && limits.ponder->load()))
+		return actions[0];
+	std::vector<Variation> result = iterate(board, 1, limits, report);
+	return result.empty() ? std::vector<Cell>() : result.front().action;
+}
+
+std::vector<Variation> Engine::analyse (const BoardState &board, int count, const Limits &limits, Report report) {
+	if (!board.color().valid() || count <= 0)
+		return {};
+	return iterate(board, count, limits, report);
+}
+
+/*
+ * Итеративное углубление: поиск повторяется на глубину 1, 2, ... полухода,
+ * пока не исчерпаны ограничения. Первая итерация всегда доводится до конца,
+ * чтобы ход был; прерванная итерация отбрасывается, и ответом служат лучшие
+ * ходы последней завершённой итерации. Каждая итерация начинает с ходов,
+ * лучших по предыдущей. Без ограничений глубина та же, что была у minimax().
+ * По часам время хода распределяет Budget; единственный по итогу ход
+ * search() возвращает сразу, не тратя времени. При обдумывании на
+ * времени соперника (Limits::ponder) углубление идёт без ограничений,
+ * а после попадания продолжается с теми же итерациями под обычными
+ * ограничениями; результаты в любом случае остаются в таблице.
+ */
+std::vector<Variation> Engine::iterate (const BoardState &board, int count, const Limits &limits, Report report) {
+	std::lock_guard<std::mutex> running(_running);
+	std::vector<std::vector<Cell>> actions = distinct(board);
+	if (actions.empty())
+		return {};
+	const Weights &balance = weights();
+	std::shared_ptr<const Network> current = network();
+	if (current != _network || balance.man != _balance.man || balance.king != _balance.king
+	    || balance.advance != _balance.advance || balance.centre != _balance.centre) {
+		clear();
+		_balance = balance;
+		_network = current;
+	}
+	if (_table)
+		_table->age();
+	for (auto &worker : _workers)
+		worker->age();
+	int depth = limits.depth > 0 ? std::min(limits.depth, MaxDepth) : MaxDepth;
+	if (limits.depth <= 0 && limits.time <= 0.0 && !limits.nodes && limits.clock <= 0.0)
+		depth = MaxLevel + 1;
+	Budget budget(limits);
+	Limits bounded = limits;
+	if (budget.hard() > 0.0)
+		bounded.time = limits.time > 0.0 ? std::min(limits.time, budget.hard()) : budget.hard();
+	_board = board;
+	_history = limits.history;
+	_depth = limits.ponder && limits.ponder->load() ? MaxDepth : depth;
+	start();
+	Control control(bounded, _workers[0]->nodes);
+	Search search(_table.get(), *_workers[0], control, _network.get());
+	search.trace(limits.history, board);
+	bool lines = report || count > 1;
+	std::vector<Variation> result;
+	for (int d = 1; d <= MaxDepth; ++ d) {
+		if (d > depth && !control.pondering())
+			break;
+		control.deepen(d > depth);
+		try {
+			result = search.rank(board, actions, count, d-1, lines);
+		}
+		catch (const Interrupted&) {
+			break;
+		}
+		control.arm();
+		for (auto v = result.rbegin(); v != result.rend(); ++ v) {
+			auto found = std::find(actions.begin(), actions.end(), v->action);
+			std::rotate(actions.begin(), found, found+1);
+		}
+		if (report && !result.empty()) {
+			Progress progress;
+			progress.depth = d;
+			progress.nodes = control.nodes();
+			for (std::size_t i = 1; i < _workers.size(); ++ i)
+				progress.nodes += _workers[i]->nodes.load(std::memory_order_relaxed);
+			progress.time = control.elapsed();
+			progress.best = result.front();
+			report(progress);
+		}
+		if (control.expired())
+			break;
+		if (!control.pondering() && !result.empty() && budget.enough(control.elapsed(), result.front(), board.color()))
+			break;
+	}
+	if (limits.wakeup) {    // Глубже некуда, но ход соперника ещё не сделан.
+		std::unique_lock<std::mutex> lock(limits.wakeup->mutex);
+		limits.wakeup->changed.wait(lock, [&control] {return control.expired() || !control.pondering();});
+	}
+	halt();
+	return result;
+}
+
+void Engine::start () {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_halt = false;
+		_busy = _threads.size();
+		++ _job;
+	}
+	_wake.notify_all();
+}
+
+void Engine::halt () {
+	_halt = true;
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this] {return _busy == 0;});
+}
+
+// Дополнительный поток углубляется сам по себе, нечётные — начиная со второй итерации.
+void Engine::work (unsigned int index) {
+	unsigned long seen = 0;
+	while (true) {
+		BoardState board;
+		const History *history;
+		int depth;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [&] {return _quit || _job != seen;});
+			if (_quit)
+				return;
+			seen = _job;
+			board = _board;
+			history = _history;
+			depth = _depth;
+		}
+		Limits limits;
+		limits.stop = &_halt;
+		Control control(limits, _workers[index]->nodes);
+		control.arm();
+		Search search(_table.get(), *_workers[index], control, _network.get());
+		search.trace(history, board);
+		std::vector<std::vector<Cell>> actions = distinct(board);
+		try {
+			for (int d = 1 + index % 2; d <= depth && !_halt; ++ d)
+				search.rank(board, actions, 1, d-1, false);
+		}
+		catch (const Interrupted&) {}
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (-- _busy == 0)
+			_idle.notify_all();
+	}
+}
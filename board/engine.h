@@ -0,0 +1,79 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "board_state.h"
+#include "minimax.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Поиск ходов, сохраняющий накопленное между вызовами.
+ *
+ * Движок владеет таблицей уже просмотренных позиций, таблицами истории
+ * и ходов-убийц для упорядочения ходов и набором потоков, которые создаются
+ * один раз. Поэтому последовательные поиски в одной партии пользуются
+ * результатами предыдущих: таблица хранит оценки и лучшие ходы позиций,
+ * встреченных при обдумывании прошлых ходов. Дополнительные потоки ищут
+ * ту же позицию независимо и делятся с основным только таблицей.
+ * Ходы, приводящие к одной и той же позиции (дамка может бить одни и те же
+ * шашки, приземляясь на разные поля), поиск рассматривает как один.
+ *
+ * Один движок не ведёт два поиска одновременно: второй вызов ждёт первого.
+ */
+
+class Engine {
+public:
+	using Report = std::function<void (const Progress&)>;
+	struct Config {
+		unsigned int threads;    // Число потоков поиска, не меньше одного.
+		std::size_t hash;        // Размер таблицы позиций в мегабайтах; 0 — без таблицы.
+		Limits limits;           // Ограничения для search() без явных ограничений.
+		Config () : threads(1), hash(16) {}
+	};
+public:
+	Engine (const Config &config = Config());
+	~Engine ();
+	const Config& config () const;
+	void configure (const Config &config);    // Не вызывать во время поиска.
+	void clear ();                            // Забыть всё накопленное, например перед новой партией.
+	std::vector<Cell> search (const BoardState &board);
+	std::vector<Cell> search (const BoardState &board, const Limits &limits, Report report = nullptr);
+	std::vector<Variation> analyse (const BoardState &board, int count, const Limits &limits,
+	                                Report report = nullptr);    // count лучших ходов, лучший первым.
+private:
+	Engine (const Engine&) = delete;
+	Engine& operator= (const Engine&) = delete;
+	struct Entry;
+	struct Worker;
+	class Table;
+	class Search;
+	std::vector<Variation> iterate (const BoardState &board, int count, const Limits &limits, Report report);
+	void start ();
+	void halt ();
+	void work (unsigned int index);
+private:
+	Config _config;
+	std::unique_ptr<Table> _table;
+	std::vector<std::unique_ptr<Worker>> _workers;    // Нулевой работает в вызывающем потоке.
+	std::vector<std::thread> _threads;
+	std::mutex _running;         // Занят на время поиска.
+	std::mutex _mutex;           // Защищает задание для дополнительных потоков.
+	std::condition_variable _wake, _idle;
+	unsigned long _job;          // Номер текущего задания.
+	unsigned int _busy;          // Столько дополнительных потоков ещё не закончили задание.
+	bool _quit;
+	std::atomic<bool> _halt;     // Дополнительным потокам пора закончить задание.
+	BoardState _board;           // Задание: позиция, партия до неё и глубина, до которой углубляться.
+	const History *_history;
+	int _depth;
+	Weights _balance;            // Оценочная функция, по которой заполнена таблица.
+	std::shared_ptr<const Network> _network;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "history.h"
+
+namespace {
+
+std::uint64_t mix (std::uint64_t x) {    // splitmix64
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+}
+
+std::uint64_t History::key (const BoardState &board) {
+	const Position &position = board.position();
+	std::uint64_t stones = position.mask(Role::White) | static_cast<std::uint64_t>(position.mask(Role::Black)) << 32;
+	std::uint64_t rest = position.kings() | static_cast<std::uint64_t>(board.color() == Role::Black) << 32;
+	return mix(mix(stones) ^ rest);
+}
+
+// Ход дамкой без взятия: после него позиция может повториться.
+bool History::reversible (const BoardState &board, const std::vector<Cell> &action) {
+	return board.quiet() && !action.empty() && board.position().king(action.front());
+}
+
+History::History (const BoardState &start) : _board(start), _keys(1, key(start)), _runs(1, 0) {}
+
+void History::play (const BoardState &next) {
+	const Position &before = _board.position(), &after = next.position();
+	std::uint32_t men = (before.mask(Role::White) | before.mask(Role::Black)) & ~before.kings();
+	bool kings = (((after.mask(Role::White) | after.mask(Role::Black)) & ~after.kings()) == men);
+	_runs.push_back(_board.quiet() && kings ? _runs.back() + 1 : 0);
+	_board = next;
+	_keys.push_back(key(_board));
+}
+
+const BoardState& History::board () const {return _board;}
+
+bool History::drawn () const {
+	int run = _runs.back();
+	if (run >= KingPlies)
+		return true;
+	int seen = 0;
+	for (int back = 2; back <= run; back += 2)
+		if (_keys[_keys.size()-1 - back] == _keys.back() && ++ seen == 2)
+			return true;
+	return false;
+}
+
+int History::run () const {return _runs.back();}
+
+const std::vector<std::uint64_t>& History::keys () const {return _keys;}
@@ -0,0 +1,34 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "board_state.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * История партии для распознавания ничьих по правилам русских шашек:
+ * позиция повторилась в третий раз (с тем же игроком на очереди) или
+ * 15 ходов подряд обе стороны ходили только дамками без взятий.
+ * Ход простой шашкой и взятие необратимы, поэтому повторения ищутся
+ * только среди позиций после последнего такого хода.
+ */
+
+class History {
+public:
+	static const int KingPlies = 30;    // Полуходов дамками без взятий до ничьей.
+	static std::uint64_t key (const BoardState &board);    // Ключ позиции после полного хода.
+	static bool reversible (const BoardState &board, const std::vector<Cell> &action);
+public:
+	History (const BoardState &start = BoardState::initialBoard());
+	void play (const BoardState &next);    // Позиция после очередного хода.
+	const BoardState& board () const;
+	bool drawn () const;    // Текущая позиция — ничья.
+	int run () const;       // Обратимых полуходов подряд до текущей позиции.
+	const std::vector<std::uint64_t>& keys () const;    // Ключи всех позиций, текущая последней.
+private:
+	BoardState _board;
+	std::vector<std::uint64_t> _keys;
+	std::vector<int> _runs;
+};
+
+#endif
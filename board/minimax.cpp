@@ -1,10 +1,18 @@
 #include "minimax.h"
+#include "engine.h"
+#include "network.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 
 const double WhiteWin = 50.0;
 const double BlackWin = 1.0 / 50.0;
-const int KingPrice = 3;
-const int ManPrice = 1;
-const int MaxLevel = 7;
+
+namespace {
+
+Weights Balance;    // Веса оценочной функции; меняются только между поисками.
+
+}
 
 std::vector<std::vector<Cell>> explore(const BoardState& board, std::vector<Cell> action) {
 	if (!action.back().valid())
@@ -24,8 +32,7 @@ std::vector<std::vector<Cell>> explore(const BoardState& board, std::vector<Cell
 
 std::vector<std::vector<Cell>> explore(const BoardState &board) {
 	std::vector<std::vector<Cell>> result;
-	std::vector<Cell> stock = board.position().stock(board.color());
-	for (Cell cell : stock) {
+	for (Cell cell : board.position().stock(board.color())) {
 		BoardState copy = board;
 		if (copy.control(cell)) {
 			auto append = explore(copy, {{cell}});
@@ -35,94 +42,104 @@ std::vector<std::vector<Cell>> explore(const BoardState &board) {
 	return result;
 }
 
-double evaluate (const BoardState &board) {
-	bool isWhite = board.color() == Role::White;
-	if (board.lost())
-		return isWhite ? BlackWin : WhiteWin;
-	std::vector<Cell> white = board.position().stock(Role::White);
-	std::vector<Cell> black = board.position().stock(Role::Black);
-	int wc = 0, bc = 0;
-	for (Cell cell : white)
-		wc += board.position().king(cell) ? KingPrice : ManPrice;
-	for (Cell cell : black)
-		bc += board.position().king(cell) ? KingPrice : ManPrice;
-	return static_cast<double>(wc)/static_cast<double>(bc);
-}
+namespace {
 
-double white(const BoardState& board, int level, double alpha, double beta);
-double black(const BoardState& board, int level, double alpha, double beta);
-
-double white(const BoardState& board, int level, double alpha, double beta) {
-	if (level <= 0 && board.quiet())
-		return evaluate(board);
-	std::vector<std::vector<Cell>> every = explore(board);
-	if (every.empty())
-		return BlackWin;
-	double result = BlackWin / 2.0;
-	for (auto action : every) {
+// Итог хода: поля белых, чёрных и дамок.
+struct Outcome {
+	std::uint32_t white, black, kings;
+	Outcome(const Position &p) : white(p.mask(Role::White)), black(p.mask(Role::Black)), kings(p.kings()) {}
+	bool operator== (const Outcome &o) const {return white == o.white && black == o.black && kings == o.kings;}
+};
+
+// Как explore(), но ход, приводящий к уже встреченной позиции, отбрасывается.
+void gather(const BoardState &board, std::vector<Cell> &action, std::vector<std::vector<Cell>> &result,
+            std::vector<Outcome> &seen) {
+	if (!action.back().valid()) {
+		Outcome outcome(board.position());
+		if (std::find(seen.begin(), seen.end(), outcome) == seen.end()) {
+			seen.push_back(outcome);
+			result.push_back(action);
+		}
+		return;
+	}
+	for (Cell cell : Cell::neighbours(action.back())) {
 		BoardState copy = board;
-		BoardState::apply(copy, action);
-		double value = black(copy, level-1, alpha, beta);
-		if (value > beta)
-			return value;
-		if (value > alpha)
-			alpha = value;
-		if (value > result)
-			result = value;
+		if (copy.control(cell)) {
+			action.push_back(cell);
+			gather(copy, action, result, seen);
+			action.pop_back();
+		}
 	}
-	return result;
 }
 
-double black(const BoardState& board, int level, double alpha, double beta) {
-	if (level <= 0 && board.quiet())
-		return evaluate(board);
-	std::vector<std::vector<Cell>> every = explore(board);
-	if (every.empty())
-		return WhiteWin;
-	double result = WhiteWin * 2.0;
-	for (auto action : every) {
+}
+
+// Без взятий разные ходы всегда дают разные позиции.
+std::vector<std::vector<Cell>> distinct(const BoardState &board) {
+	if (board.quiet())
+		return explore(board);
+	std::vector<std::vector<Cell>> result;
+	std::vector<Outcome> seen;
+	for (Cell cell : board.position().stock(board.color())) {
 		BoardState copy = board;
-		BoardState::apply(copy, action);
-		double value = white(copy, level-1, alpha, beta);
-		if (value < alpha)
-			return value;
-		if (value < beta)
-			beta = value;
-		if (value < result)
-			result = value;
+		if (copy.control(cell)) {
+			std::vector<Cell> action = {cell};
+			gather(copy, action, result, seen);
+		}
 	}
 	return result;
 }
 
+double evaluate (const BoardState &board) {
+	bool isWhite = board.color() == Role::White;
+	if (board.lost())
+		return isWhite ? BlackWin : WhiteWin;
+	const Position& position = board.position();
+	double wc = Balance.strength(Material(position, Role::White));
+	double bc = Balance.strength(Material(position, Role::Black));
+	return wc/bc;
+}
+
+const Weights& weights() {return Balance;}
+void useWeights(const Weights &weights) {Balance = weights;}
+
+namespace {
+
+std::shared_ptr<const Network> Current;    // Сеть для оценки листьев, если загружена.
+
+// Движок для функций ниже; создаётся при первом поиске.
+Engine& shared() {
+	static Engine engine;
+	return engine;
+}
+
+}
+
+void useNetwork(std::shared_ptr<const Network> network) {
+	std::atomic_store(&Current, network);
+}
+
+std::shared_ptr<const Network> network() {
+	return std::atomic_load(&Current);
+}
+
 std::vector<Cell> minimax(BoardState board) {
-	std::vector<std::vector<Cell>> actions = explore(board);
-	if (actions.empty() || !board.color().valid())
-		return {};
-	if (actions.size() == 1)
-		return actions[0];
-	int index = 0;
-	double alpha = BlackWin, beta = WhiteWin;
-	if (board.color() == Role::White) {
-		for (unsigned int i = 0; i < actions.size(); ++ i) {
-			BoardState copy = board;
-			BoardState::apply(copy, actions[i]);
-			double value = black(copy, MaxLevel, alpha, beta);
-			if (value > alpha) {
-				alpha = value;
-				index = i;
-			}
-		}
-	}
-	else {
-		for (unsigned int i = 0; i < actions.size(); ++ i) {
-			BoardState copy = board;
-			BoardState::apply(copy, actions[i]);
-			double value = white(copy, MaxLevel, alpha, beta);
-			if (value < beta) {
-				beta = value;
-				index = i;
-			}
-		}
-	}
-	return actions[index];
+	return shared().search(board);
+}
+
+std::vector<Variation> analyse(BoardState board, int count) {
+	return shared().analyse(board, count, Limits());
+}
+
+std::vector<Cell> search(BoardState board, const Limits &limits, std::function<void (const Progress&)> report) {
+	return shared().search(board, limits, report);
+}
+
+std::vector<Cell> action(const BoardState &board, const std::string &notation) {
+	std::string wanted = notation;
+	std::transform(wanted.begin(), wanted.end(), wanted.begin(), ::toupper);
+	for (const std::vector<Cell> &candidate : explore(board))
+		if (board.notation(candidate) == wanted)
+			return candidate;
+	return {};
 }
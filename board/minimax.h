@@ -2,8 +2,83 @@
 #define MINIMAX_H
 
 #include "board_state.h"
+#include "weights.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
+class Network;
+class History;
+
+extern const double WhiteWin;      // Оценка позиции, в которой белые выиграли.
+extern const double BlackWin;      // Оценка позиции, в которой чёрные выиграли.
+
+std::vector<std::vector<Cell>> explore(const BoardState &board);    // Все полные ходы.
+std::vector<std::vector<Cell>> distinct(const BoardState &board);   // Ходы к разным позициям: из ведущих к одной — первый по explore().
+double evaluate(const BoardState &board);     // Оценка: отношение сил белых к силам чёрных.
 std::vector<Cell> minimax(BoardState board);
 
+// Один из лучших ходов с точной оценкой и главным продолжением, начиная с этого хода.
+struct Variation {
+	std::vector<Cell> action;
+	double score;
+	std::vector<std::vector<Cell>> line;
+};
+
+std::vector<Variation> analyse(BoardState board, int count);    // count лучших ходов, лучший первым.
+
+// Оповещение об изменении флагов stop и ponder. Поиск, которому при обдумывании
+// больше нечего делать, ждёт здесь ответа соперника или остановки.
+struct Wakeup {
+	std::mutex mutex;
+	std::condition_variable changed;
+	void set (std::atomic<bool> &flag, bool value) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			flag = value;
+		}
+		changed.notify_all();
+	}
+};
+
+// Ограничения поиска; нулевое значение означает отсутствие ограничения.
+// Без глубины, времени, узлов и часов поиск идёт на глубину minimax().
+struct Limits {
+	int depth;                        // Глубина в полуходах.
+	double time;                      // Время в секундах.
+	unsigned long long nodes;         // Число просмотренных позиций.
+	const std::atomic<bool> *stop;    // Поиск прекращается, когда здесь станет true.
+	double clock;                     // Остаток на часах ходящего в секундах; время хода выбирает поиск.
+	double increment;                 // Добавка к часам после хода.
+	int moves;                        // Ходов до следующего контроля; 0 — до конца партии.
+	const std::atomic<bool> *ponder;  // Пока здесь true, ход соперника ещё обдумывается и ограничения
+	                                  // не действуют; false — соперник сыграл ожидаемый ход.
+	Wakeup *wakeup;                   // Через него меняются stop и ponder; без него поиск,
+	                                  // углубившись до предела, не ждёт конца обдумывания.
+	const History *history;           // Партия, закончившаяся искомой позицией, для поиска повторений.
+	Limits () : depth(0), time(0.0), nodes(0), stop(nullptr), clock(0.0), increment(0.0), moves(0),
+	            ponder(nullptr), wakeup(nullptr), history(nullptr) {}
+};
+
+// Итог очередной завершённой итерации поиска.
+struct Progress {
+	int depth;
+	unsigned long long nodes;
+	double time;                      // Секунды от начала поиска.
+	Variation best;
+};
+
+// Поиск с итеративным углублением; без ограничений — на глубину minimax().
+std::vector<Cell> search(BoardState board, const Limits &limits,
+                         std::function<void (const Progress&)> report = nullptr);
+std::vector<Cell> action(const BoardState &board, const std::string &notation);    // Пуст, если хода нет.
+void useNetwork(std::shared_ptr<const Network> network);    // nullptr возвращает evaluate().
+std::shared_ptr<const Network> network();                   // Текущая сеть или nullptr.
+const Weights& weights();
+void useWeights(const Weights &weights);    // Не вызывать во время поиска.
+
 #endif
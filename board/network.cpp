@@ -0,0 +1,250 @@
+#include "network.h"
+#include "bits.h"
+#include "minimax.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NETWORK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NETWORK_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const double Limit = 40.0;     // Оценка сети не выходит за пределы [1/Limit, Limit].
+const int Shift = 6;           // Сдвиг после второго слоя.
+
+std::uint32_t readWord(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+inline std::uint8_t clip(int value) {
+	return static_cast<std::uint8_t>(std::min(127, std::max(0, value)));
+}
+
+// Поля каждого из четырёх видов признаков: белые простые, белые дамки, чёрные...
+void features(const Position &position, std::uint32_t masks[4]) {
+	for (int color = Role::White; color <= Role::Black; ++ color) {
+		masks[2*color] = position.mask(color) & ~position.kings();
+		masks[2*color+1] = position.mask(color) & position.kings();
+	}
+}
+
+void addColumn(std::int16_t *values, const std::int16_t *column, int sign) {
+	for (int j = 0; j < Network::Hidden; ++ j)
+		values[j] += sign * column[j];
+}
+
+int dense(const std::uint8_t *input, const std::int8_t *weights) {
+	int sum = 0;
+	for (int j = 0; j < Network::Hidden; ++ j)
+		sum += input[j] * weights[j];
+	return sum;
+}
+
+#ifdef NETWORK_X86
+
+static_assert(Network::Hidden == 32, "AVX2 kernels handle exactly 32 hidden values");
+
+__attribute__((target("avx2")))
+void addColumnAvx2(std::int16_t *values, const std::int16_t *column, int sign) {
+	for (int j = 0; j < Network::Hidden; j += 16) {
+		__m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + j));
+		__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + j));
+		v = sign > 0 ? _mm256_add_epi16(v, c) : _mm256_sub_epi16(v, c);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(values + j), v);
+	}
+}
+
+__attribute__((target("avx2")))
+int denseAvx2(const std::uint8_t *input, const std::int8_t *weights) {
+	__m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+	__m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights));
+	__m256i sum = _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), _mm256_set1_epi16(1));
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(half);
+}
+
+#endif
+
+void add(std::int16_t *values, const std::int16_t *column, int sign, Network::Kernel kernel) {
+#ifdef NETWORK_X86
+	if (kernel == Network::Avx2)
+		return addColumnAvx2(values, column, sign);
+#endif
+	addColumn(values, column, sign);
+}
+
+int product(const std::uint8_t *input, const std::int8_t *weights, Network::Kernel kernel) {
+#ifdef NETWORK_X86
+	if (kernel == Network::Avx2)
+		return denseAvx2(input, weights);
+#endif
+	return dense(input, weights);
+}
+
+bool littleEndian() {
+	const std::uint16_t one = 1;
+	return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+}
+
+bool Network::supported (Kernel kernel) {
+	switch (kernel) {
+	case Scalar: return true;
+#ifdef NETWORK_X86
+	case Avx2: return __builtin_cpu_supports("avx2");
+#endif
+	default: return false;
+	}
+}
+
+Network::Kernel Network::best () {
+	static const Kernel kernel = supported(Avx2) ? Avx2 : Scalar;
+	return kernel;
+}
+
+const char* Network::name (Kernel kernel) {
+	switch (kernel) {
+	case Scalar: return "scalar";
+	case Avx2: return "avx2";
+	default: return "";
+	}
+}
+
+Network::Network () : _kernel(Scalar), _mapping(nullptr), _size(0) {}
+
+Network::~Network () {
+#ifdef NETWORK_MMAP
+	if (_mapping)
+		munmap(_mapping, _size);
+#endif
+}
+
+std::shared_ptr<const Network> Network::load (const std::string &path, Kernel kernel) {
+	if (!supported(kernel))
+		return nullptr;
+	std::shared_ptr<Network> network(new Network);
+	network->_kernel = kernel;
+	const unsigned char *data = nullptr;
+	std::size_t size = 0;
+#ifdef NETWORK_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			network->_mapping = mapping;
+			network->_size = info.st_size;
+			data = static_cast<const unsigned char*>(mapping);
+			size = info.st_size;
+		}
+	}
+	close(fd);
+#endif
+	if (!data) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return nullptr;
+		network->_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data = reinterpret_cast<const unsigned char*>(network->_buffer.data());
+		size = network->_buffer.size();
+	}
+	if (!network->bind(data, size))
+		return nullptr;
+	return network;
+}
+
+bool Network::bind (const unsigned char *data, std::size_t size) {
+	const std::size_t header = 20;
+	const std::size_t total = header + 2*(Inputs*Hidden + Hidden) + Second*Hidden
+	                          + 4*Second + Second + 4*2;
+	// Веса читаются прямо из файла, поэтому порядок байтов должен совпадать.
+	if (!littleEndian() || size != total || std::memcmp(data, "SHNN", 4) != 0)
+		return false;
+	if (readWord(data+4) != 1 || readWord(data+8) != Inputs
+	    || readWord(data+12) != Hidden || readWord(data+16) != Second)
+		return false;
+	const unsigned char *p = data + header;
+	_inputWeights = reinterpret_cast<const std::int16_t*>(p);
+	p += 2*Inputs*Hidden;
+	_inputBias = reinterpret_cast<const std::int16_t*>(p);
+	p += 2*Hidden;
+	_hiddenWeights = reinterpret_cast<const std::int8_t*>(p);
+	p += Second*Hidden;
+	_hiddenBias = reinterpret_cast<const std::int32_t*>(p);
+	p += 4*Second;
+	_outputWeights = reinterpret_cast<const std::int8_t*>(p);
+	p += Second;
+	_outputBias = reinterpret_cast<const std::int32_t*>(p);
+	return true;
+}
+
+int Network::feature (Cell cell, bool king, Role color) {
+	return 64*color + 32*king + cell.index();
+}
+
+void Network::refresh (const Position &position, Accumulator &accumulator) const {
+	std::copy(_inputBias, _inputBias + Hidden, accumulator.values);
+	std::uint32_t masks[4];
+	features(position, masks);
+	for (int kind = 0; kind < 4; ++ kind)
+		for (Cell cell : Stock(masks[kind]))
+			add(accumulator.values, _inputWeights + (32*kind + cell.index())*Hidden, +1, _kernel);
+}
+
+void Network::update (const Accumulator &parent, const Position &from, const Position &to,
+                      Accumulator &child) const {
+	child = parent;
+	std::uint32_t before[4], after[4];
+	features(from, before);
+	features(to, after);
+	for (int kind = 0; kind < 4; ++ kind) {
+		for (Cell cell : Stock(before[kind] & ~after[kind]))
+			add(child.values, _inputWeights + (32*kind + cell.index())*Hidden, -1, _kernel);
+		for (Cell cell : Stock(after[kind] & ~before[kind]))
+			add(child.values, _inputWeights + (32*kind + cell.index())*Hidden, +1, _kernel);
+	}
+}
+
+int Network::propagate (const Accumulator &accumulator, Role color) const {
+	alignas(32) std::uint8_t first[Hidden];
+	alignas(32) std::uint8_t second[Second];
+	for (int j = 0; j < Hidden; ++ j)
+		first[j] = clip(accumulator.values[j]);
+	for (int k = 0; k < Second; ++ k)
+		second[k] = clip((_hiddenBias[k] + product(first, _hiddenWeights + k*Hidden, _kernel)) >> Shift);
+	int output = _outputBias[color == Role::Black];
+	for (int k = 0; k < Second; ++ k)
+		output += second[k] * _outputWeights[k];
+	return output;
+}
+
+double Network::evaluate (const BoardState &board, const Accumulator &accumulator) const {
+	if (board.lost())
+		return board.color() == Role::White ? BlackWin : WhiteWin;
+	double score = std::exp(static_cast<double>(propagate(accumulator, board.color())) / Scale);
+	return std::min(Limit, std::max(1.0 / Limit, score));
+}
+
+double Network::evaluate (const BoardState &board) const {
+	Accumulator accumulator;
+	refresh(board.position(), accumulator);
+	return evaluate(board, accumulator);
+}
@@ -0,0 +1,72 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "board_state.h"
+
+/*
+ * Оценка позиции небольшой нейронной сетью с обновляемым входным слоем.
+ *
+ * Вход — 128 признаков: поле (32) × вид шашки (простая, дамка) × цвет.
+ * Первый слой хранится как накопитель: сумма столбцов весов для всех
+ * признаков, присутствующих в позиции. При переходе к следующей позиции
+ * накопитель меняется только на столбцы появившихся и исчезнувших шашек,
+ * поэтому поиску не нужно пересчитывать его с нуля. Дальше идут два малых
+ * плотных слоя с весами int8 и выход, зависящий от цвета хода.
+ *
+ * Веса читаются из двоичного файла, который отображается в память:
+ *   "SHNN", версия 1, размеры 128, Hidden, Second (по uint32),
+ *   int16 входные веса [128][Hidden], int16 смещения [Hidden],
+ *   int8 веса [Second][Hidden], int32 смещения [Second],
+ *   int8 веса [Second], int32 смещения выхода [2] (ход белых, ход чёрных).
+ * Все числа записаны в порядке little-endian; на машинах с обратным порядком
+ * байтов файл не принимается.
+ *
+ * Ядро для накопителя и плотного слоя выбирается при загрузке; скалярное
+ * и AVX2 дают одинаковые результаты.
+ */
+
+class Network {
+public:
+	static const int Inputs = 128;
+	static const int Hidden = 32;
+	static const int Second = 32;
+	static const int Scale = 1024;     // Столько единиц выхода меняют оценку в e раз.
+	struct Accumulator {
+		alignas(32) std::int16_t values[Hidden];
+	};
+	enum Kernel {Scalar = 0, Avx2};
+	static Kernel best ();                   // Самое быстрое ядро на этом процессоре.
+	static bool supported (Kernel kernel);
+	static const char* name (Kernel kernel);
+	static std::shared_ptr<const Network> load (const std::string &path, Kernel kernel = best());    // nullptr при ошибке.
+	static int feature (Cell cell, bool king, Role color);
+public:
+	~Network ();
+	void refresh (const Position &position, Accumulator &accumulator) const;
+	void update (const Accumulator &parent, const Position &from, const Position &to,
+	             Accumulator &child) const;
+	double evaluate (const BoardState &board, const Accumulator &accumulator) const;
+	double evaluate (const BoardState &board) const;
+private:
+	Network ();
+	Network (const Network&) = delete;
+	Network& operator= (const Network&) = delete;
+	bool bind (const unsigned char *data, std::size_t size);
+	int propagate (const Accumulator &accumulator, Role color) const;
+private:
+	Kernel _kernel;
+	void *_mapping;            // Отображённый в память файл весов.
+	std::size_t _size;
+	std::string _buffer;       // Содержимое файла там, где отображение недоступно.
+	const std::int16_t *_inputWeights;
+	const std::int16_t *_inputBias;
+	const std::int8_t *_hiddenWeights;
+	const std::int32_t *_hiddenBias;
+	const std::int8_t *_outputWeights;
+	const std::int32_t *_outputBias;
+};
+
+#endif
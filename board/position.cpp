@@ -1,9 +1,19 @@
 #include "position.h"
-#include <algorithm>
+#include "bits.h"
 
-Position::Position(Stone *cells) {
-	if (cells) for (int i = 0; i < 32; ++ i)
+Position::Position(Stone *cells) : _mask{0, 0}, _kings(0), _ghosts(0), _tally() {
+	if (cells) for (int i = 0; i < 32; ++ i) {
 		_cells[i] = cells[i];
+		if (!_cells[i].color.valid())
+			continue;
+		account(Cell::fromIndex(i), _cells[i].color, _cells[i].king, +1);
+		std::uint32_t bit = 1u << i;
+		_mask[_cells[i].color] |= bit;
+		if (_cells[i].king)
+			_kings |= bit;
+		if (_cells[i].ghost)
+			_ghosts |= bit;
+	}
 }
 
 Role Position::color(Cell cell) const {
@@ -24,12 +34,44 @@ bool Position::ghost(Cell cell) const {
 	return _cells[cell.index()].ghost;
 }
 
-std::vector<Cell> Position::stock(Role role) const {
-	std::vector<Cell> answer;
-	for (int i = 0; i < 32; ++ i)
-		if (!role.valid() || _cells[i].color == role)
-			answer.push_back(Cell::fromIndex(i));
-	return answer;
+Stock Position::stock(Role role) const {
+	return Stock(mask(role));
+}
+
+std::uint32_t Position::mask(Role role) const {
+	return role.valid() ? _mask[role] : 0xFFFFFFFFu;
+}
+
+std::uint32_t Position::kings() const {return _kings;}
+
+unsigned int Position::count(Role role) const {
+	return role.valid() ? _tally[role].men + _tally[role].kings : 0;
+}
+
+unsigned int Position::count(Role role, bool king) const {
+	if (!role.valid())
+		return 0;
+	return king ? _tally[role].kings : _tally[role].men;
+}
+
+unsigned int Position::advance(Role role) const {
+	return role.valid() ? _tally[role].advance : 0;
+}
+
+unsigned int Position::centre(Role role) const {
+	return role.valid() ? _tally[role].centre : 0;
+}
+
+void Position::account(Cell cell, Role color, bool king, int sign) {
+	Tally &tally = _tally[color];
+	if (king)
+		tally.kings += sign;
+	else {
+		tally.men += sign;
+		tally.advance += sign * static_cast<int>(color == Role::White ? cell.rank() : 7 - cell.rank());
+	}
+	if ((Centre >> cell.index()) & 1u)
+		tally.centre += sign;
 }
 
 Position::Stone Position::at(Cell cell) const {
@@ -38,25 +80,31 @@ Position::Stone Position::at(Cell cell) const {
 	return _cells[cell.index()];
 }
 
-Position::Stone* Position::access(Cell cell) {
-	if (!cell.valid())
-		return nullptr;
-	return &_cells[cell.index()];
-}
-
 bool Position::move(Cell from, Cell to) {
 	if (!_cells[from.index()].color.valid() || _cells[to.index()].color.valid())
 		return false;
-	_cells[to.index()].color = _cells[from.index()].color;
+	Role color = _cells[from.index()].color;
+	account(from, color, _cells[from.index()].king, -1);
+	account(to, color, _cells[from.index()].king, +1);
+	std::uint32_t fromBit = 1u << from.index(), toBit = 1u << to.index();
+	_cells[to.index()].color = color;
 	_cells[to.index()].king = _cells[from.index()].king;
 	_cells[from.index()].color = Role::None;
+	_mask[color] ^= fromBit | toBit;
+	if (_kings & fromBit)
+		_kings ^= fromBit | toBit;
 	return true;
 }
 
 bool Position::promote(Cell cell) {
 	if (!_cells[cell.index()].color.valid())
 		return false;
+	if (_cells[cell.index()].king)
+		return true;
+	account(cell, _cells[cell.index()].color, false, -1);
+	account(cell, _cells[cell.index()].color, true, +1);
 	_cells[cell.index()].king = true;
+	_kings |= 1u << cell.index();
 	return true;
 }
 
@@ -64,15 +112,20 @@ bool Position::kill(Cell cell) {
 	if (!_cells[cell.index()].color.valid())
 		return false;
 	_cells[cell.index()].ghost = true;
+	_ghosts |= 1u << cell.index();
 	return true;
 }
 
 void Position::removeGhosts() {
-	for (int i = 0; i < 32; ++ i)
-		if (_cells[i].ghost) {
-			_cells[i].ghost = false;
-			_cells[i].color = Role::None;
-		}
+	for (Cell cell : Stock(_ghosts)) {
+		account(cell, _cells[cell.index()].color, _cells[cell.index()].king, -1);
+		_cells[cell.index()].ghost = false;
+		_cells[cell.index()].color = Role::None;
+	}
+	_mask[Role::White] &= ~_ghosts;
+	_mask[Role::Black] &= ~_ghosts;
+	_kings &= ~_ghosts;
+	_ghosts = 0;
 }
 
 Position::Motion Position::accepts(Cell thru, Direction direction) const {
@@ -110,12 +163,67 @@ Position::Motion Position::accepts(Cell thru, Direction direction, Role color, b
 	return Block;
 }
 
+namespace {
+
+// Сдвиги масок по направлениям LeftForward, RightForward, RightBackward, LeftBackward.
+std::uint32_t (*const Shifts[4])(std::uint32_t) = {
+	shiftLeftForward, shiftRightForward, shiftRightBackward, shiftLeftBackward,
+};
+
+// Простые шашки на горизонтали превращения бьют как дамки.
+std::uint32_t promotionRank(Role color) {
+	return color == Role::White ? RanksFrom[7] : RanksUpTo[0];
+}
+
+}
+
+/*
+ * Проверки всей доски сразу, по маскам: простые бьют на соседнее поле
+ * в любую сторону, дамка — на любое расстояние по пустым полям. Призраки
+ * не пускают дальше и не берутся второй раз.
+ */
+
+bool Position::canCapture(Role color) const {
+	if (!color.valid())
+		return false;
+	std::uint32_t own = _mask[color], prey = _mask[color.opposite()] & ~_ghosts;
+	std::uint32_t empty = ~(_mask[Role::White] | _mask[Role::Black]);
+	std::uint32_t kings = own & (_kings | promotionRank(color)), men = own & ~kings;
+	for (auto shift : Shifts) {
+		if (shift(shift(men) & prey) & empty)
+			return true;
+		for (std::uint32_t ray = shift(kings); ray; ray = shift(ray & empty))
+			if (shift(ray & prey) & empty)
+				return true;
+	}
+	return false;
+}
+
+bool Position::canMove(Role color) const {
+	if (!color.valid())
+		return false;
+	std::uint32_t own = _mask[color], empty = ~(_mask[Role::White] | _mask[Role::Black]);
+	std::uint32_t kings = own & _kings, men = own & ~_kings;
+	std::uint32_t forward = color == Role::White ? shiftLeftForward(men) | shiftRightForward(men)
+	                                             : shiftLeftBackward(men) | shiftRightBackward(men);
+	if (forward & empty)
+		return true;
+	for (auto shift : Shifts)
+		if (shift(kings) & empty)
+			return true;
+	return canCapture(color);
+}
+
 bool Position::captures(Cell thru, Direction direction, Role color, bool king) const {
 	if (thru.promotion(color))
 		king = true;
 	while (true)
 		switch (accepts(thru, direction, color, king)) {
-		case Slow: if (king) {thru = thru.neighbour(direction); break;}
+		case Slow:
+			if (!king)
+				return false;
+			thru = thru.neighbour(direction);
+			break;
 		case Block: return false;
 		case Capture: return true;
 		}
@@ -1,11 +1,17 @@
 #ifndef POSITION_H
 #define POSITION_H
 
-#include <vector>
+#include <cstdint>
 #include "role.h"
 #include "cell.h"
+#include "stock.h"
 
-// Позиция на шашечной доске. Пассивные данные.
+/*
+ * Позиция на шашечной доске. Пассивные данные. Кроме полей позиция
+ * ведёт сводку по каждому цвету — число простых и дамок, пройденные
+ * простыми горизонтали, шашки в центре — и обновляет её при каждом
+ * изменении, так что оценке не нужно обходить доску.
+ */
 
 class Position {
 public:
@@ -20,20 +26,36 @@ public:
 	bool king (Cell cell) const;
 	bool ghost (Cell cell) const;
 	Stone at (Cell cell) const;
-	std::vector<Cell> stock (Role role) const;
+	Stock stock (Role role) const;                 // Поля с шашками цвета role (все поля при None).
+	unsigned int count (Role role) const;          // Число шашек цвета role.
+	unsigned int count (Role role, bool king) const;
+	unsigned int advance (Role role) const;        // Сумма горизонталей, пройденных простыми от своего края.
+	unsigned int centre (Role role) const;         // Число шашек на центральных полях.
+	std::uint32_t mask (Role role) const;
+	std::uint32_t kings () const;
 
 	bool move (Cell from, Cell to);
 	bool promote (Cell cell);
 	bool kill (Cell cell);
-	Stone* access (Cell cell);
 	void removeGhosts ();
 
 	Motion accepts (Cell thru, Direction direction) const;  // Тип прохода через поле.
 	bool captures (Cell thru, Direction direction) const;   // Дорога содержит взятия.
 	Motion accepts (Cell thru, Direction direction, Role color, bool king) const;
 	bool captures (Cell thru, Direction direction, Role color, bool king) const;
+	bool canCapture (Role color) const;    // Какая-нибудь шашка цвета color может бить.
+	bool canMove (Role color) const;       // Какая-нибудь шашка цвета color может ходить.
+private:
+	struct Tally {
+		std::uint8_t men, kings, advance, centre;
+	};
+	void account (Cell cell, Role color, bool king, int sign);    // Учесть шашку в сводке или убрать.
 private:
 	Stone _cells[32];
+	std::uint32_t _mask[2];    // Поля, занятые шашками каждого цвета (и призраками).
+	std::uint32_t _kings;      // Поля, занятые дамками.
+	std::uint32_t _ghosts;     // Поля, занятые призраками.
+	Tally _tally[2];           // Сводка по цветам; призраки в ней, как и в масках, до removeGhosts().
 };
 
 #endif
@@ -5,12 +5,12 @@
 
 class Role {
 public:
-	Role ();
-	Role (int index);
-	operator int () const;
-	bool valid () const;
-	Role opposite () const;
-	Role next () const;
+	constexpr Role () : _value(None) {}
+	constexpr Role (int index) : _value(index == White || index == Black ? index : None) {}
+	constexpr operator int () const {return _value;}
+	constexpr bool valid () const {return _value != None;}
+	constexpr Role opposite () const {return _value == White ? Black : _value == Black ? White : None;}
+	constexpr Role next () const {return _value == White ? Black : _value == Black ? None : White;}
 public:
 	static const int White = 0;
 	static const int Black = 1;
@@ -0,0 +1,24 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+
+// Ряд подряд лежащих элементов постоянного массива, например таблицы. Пассивные данные.
+
+template <typename T>
+class Span {
+public:
+	constexpr Span (const T *begin, std::size_t size) : _begin(begin), _size(size) {}
+	template <std::size_t N>
+	constexpr Span (const T (&array)[N]) : _begin(array), _size(N) {}
+	constexpr const T* begin () const {return _begin;}
+	constexpr const T* end () const {return _begin + _size;}
+	constexpr std::size_t size () const {return _size;}
+	constexpr bool empty () const {return _size == 0;}
+	constexpr const T& operator[] (std::size_t i) const {return _begin[i];}
+private:
+	const T *_begin;
+	std::size_t _size;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef STOCK_H
+#define STOCK_H
+
+#include <cstdint>
+#include "bits.h"
+#include "cell.h"
+
+// Набор полей, заданный битовой маской. Перебор полей не выделяет памяти
+// и целиком встраивается в циклы по шашкам.
+
+class Stock {
+public:
+	class Iterator {
+	public:
+		Cell operator* () const;
+		Iterator& operator++ ();
+	private:
+		friend class Stock;
+		friend bool operator== (Iterator it1, Iterator it2);
+		friend bool operator!= (Iterator it1, Iterator it2);
+		Iterator (std::uint32_t rest);
+	private:
+		std::uint32_t _rest;    // Поля, которые ещё не пройдены.
+	};
+public:
+	Stock (std::uint32_t mask = 0);
+	Iterator begin () const;
+	Iterator end () const;
+	unsigned int size () const;
+	bool empty () const;
+	bool contains (Cell cell) const;
+	std::uint32_t mask () const;
+private:
+	std::uint32_t _mask;
+};
+
+inline Stock::Stock (std::uint32_t mask) : _mask(mask) {}
+inline Stock::Iterator::Iterator (std::uint32_t rest) : _rest(rest) {}
+
+inline Stock::Iterator Stock::begin () const {return Iterator(_mask);}
+inline Stock::Iterator Stock::end () const {return Iterator(0);}
+inline unsigned int Stock::size () const {return countBits(_mask);}
+inline bool Stock::empty () const {return _mask == 0;}
+inline std::uint32_t Stock::mask () const {return _mask;}
+
+inline bool Stock::contains (Cell cell) const {
+	return cell.valid() && (_mask >> cell.index()) & 1u;
+}
+
+inline bool operator== (Stock::Iterator it1, Stock::Iterator it2) {return it1._rest == it2._rest;}
+inline bool operator!= (Stock::Iterator it1, Stock::Iterator it2) {return it1._rest != it2._rest;}
+inline Cell Stock::Iterator::operator* () const {return Cell::fromIndex(lowestBit(_rest));}
+
+inline Stock::Iterator& Stock::Iterator::operator++ () {
+	_rest &= _rest-1;
+	return *this;
+}
+
+#endif
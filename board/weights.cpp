@@ -0,0 +1,39 @@
+#include "weights.h"
+#include <fstream>
+#include <iomanip>
+
+double Weights::strength (const Material &material) const {
+	return man*material.men + king*material.kings + advance*material.advance + centre*material.centre;
+}
+
+bool Weights::load (const std::string &path) {
+	std::ifstream file(path);
+	if (!file)
+		return false;
+	Weights result = *this;
+	std::string name;
+	double value;
+	while (file >> name >> value) {
+		if (name == "man")
+			result.man = value;
+		else if (name == "king")
+			result.king = value;
+		else if (name == "advance")
+			result.advance = value;
+		else if (name == "centre")
+			result.centre = value;
+		else
+			return false;
+	}
+	if (!file.eof())
+		return false;
+	*this = result;
+	return true;
+}
+
+bool Weights::save (const std::string &path) const {
+	std::ofstream file(path);
+	file << std::setprecision(17);
+	file << "man " << man << "\nking " << king << "\nadvance " << advance << "\ncentre " << centre << '\n';
+	return static_cast<bool>(file);
+}
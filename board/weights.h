@@ -0,0 +1,50 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include <cstdint>
+#include <string>
+#include "position.h"
+#include "bits.h"
+
+/*
+ * Веса оценочной функции. Сила стороны — взвешенная сумма её признаков,
+ * оценка позиции — отношение силы белых к силе чёрных. Поэтому веса имеют
+ * смысл с точностью до общего множителя, и цена простой шашки служит единицей.
+ */
+
+struct Material {
+	unsigned int men;        // Число простых шашек.
+	unsigned int kings;      // Число дамок.
+	unsigned int advance;    // Сумма горизонталей, пройденных простыми шашками от своего края.
+	unsigned int centre;     // Число шашек на восьми центральных полях.
+	Material (const Position &position, Role color);
+	Material (std::uint32_t own, std::uint32_t kings, Role color);    // По маскам полей.
+	Material () : men(0), kings(0), advance(0), centre(0) {}
+};
+
+struct Weights {
+	double man = 1.0;
+	double king = 3.0;
+	double advance = 0.0;
+	double centre = 0.0;
+	double strength (const Material &material) const;
+	bool load (const std::string &path);     // Файл из строк вида "king 3.0".
+	bool save (const std::string &path) const;
+};
+
+// По сводке, которую ведёт позиция.
+inline Material::Material (const Position &position, Role color)
+	: men(position.count(color, false)), kings(position.count(color, true)),
+	  advance(position.advance(color)), centre(position.centre(color)) {}
+
+inline Material::Material (std::uint32_t own, std::uint32_t kings, Role color) {
+	std::uint32_t men = own & ~kings;
+	this->men = countBits(men);
+	this->kings = countBits(own & kings);
+	advance = 0;
+	for (unsigned int rank = 1; rank < 8; ++ rank)
+		advance += countBits(men & (color == Role::White ? RanksFrom[rank] : RanksUpTo[7-rank]));
+	centre = countBits(own & Centre);
+}
+
+#endif
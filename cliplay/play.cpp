@@ -1,5 +1,9 @@
 #include "../board/board_state.h"
+#include "../board/clock.h"
+#include "../board/history.h"
 #include "../board/minimax.h"
+#include "../board/network.h"
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -136,7 +140,7 @@ BoardState quietMotion(BoardState initial, std::istringstream &in) {
 	return initial;
 }
 
-BoardState playHuman(BoardState initial) {
+BoardState playHuman(BoardState initial, const Clock &, const History &) {
 	if (initial.lost() || !initial.finished())
 		return BoardState();
 	BoardState board;
@@ -171,14 +175,17 @@ BoardState playHuman(BoardState initial) {
 	return board;
 }
 
-BoardState playAutomatic(BoardState initial) {
+BoardState playAutomatic(BoardState initial, const Clock &clock, const History &history) {
 	std::cout << "Waiting till the move is computed... " << std::flush;
-	BoardState::apply(initial, minimax(initial));
+	Limits limits;
+	limits.history = &history;
+	clock.limit(limits);
+	BoardState::apply(initial, search(initial, limits));
 	std::cout << "The computer has moved.\n";
 	return initial;
 }
 
-using PlayerFunction = BoardState (*)(BoardState);
+using PlayerFunction = BoardState (*)(BoardState, const Clock&, const History&);
 
 void setPlayers(PlayerFunction players[2]) {
 	Role human;
@@ -198,7 +205,38 @@ void setPlayers(PlayerFunction players[2]) {
 	players[human.opposite()] = playAutomatic;
 }
 
-int main() {
+int main(int argc, char **argv) {
+	Clock clocks[2];
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if (arg == "--network" && i+1 < argc) {
+			std::shared_ptr<const Network> network = Network::load(argv[++ i]);
+			if (!network) {
+				std::cout << "Cannot load the network from " << argv[i] << ".\n";
+				return 1;
+			}
+			useNetwork(network);
+		}
+		else if (arg == "--weights" && i+1 < argc) {
+			Weights weights;
+			if (!weights.load(argv[++ i])) {
+				std::cout << "Cannot load the weights from " << argv[i] << ".\n";
+				return 1;
+			}
+			useWeights(weights);
+		}
+		else if (arg == "--clock" && i+1 < argc) {
+			if (!Clock::parse(argv[++ i], clocks[Role::White])) {
+				std::cout << "Bad time control " << argv[i] << "; use e.g. 300, 300+2 or 40/600.\n";
+				return 1;
+			}
+			clocks[Role::Black] = clocks[Role::White];
+		}
+		else {
+			std::cout << "Usage: " << argv[0] << " [--network FILE] [--weights FILE] [--clock CONTROL]\n";
+			return 1;
+		}
+	}
 	PlayerFunction players[2];
 	setPlayers(players);
 	std::cout << "The format of a move: <CELL> (<DIRECTION> <COUNT>)+\n";
@@ -207,12 +245,27 @@ int main() {
 	std::cout << "<COUNT> tells the king how many motions to make after its first target.\n";
 	std::cout << "You can enter 'quit' to go out.\n\n";
 	BoardState board = BoardState::initialBoard();
+	History history(board);
 	printBoard(board);
 	while (!board.lost()) {
-		board = players[board.color()](board);
+		Role color = board.color();
+		clocks[color].start();
+		board = players[color](board, clocks[color], history);
 		if (board.color() == Role::None)
 			return 0;
+		if (!clocks[color].stop()) {
+			std::cout << "The " << (color == Role::White ? "White" : "Black") << " has lost on time.\n";
+			return 0;
+		}
 		printBoard(board);
+		if (clocks[color].enabled())
+			std::cout << std::fixed << std::setprecision(1) << "Clocks: White " << clocks[Role::White].remaining()
+			          << " s, Black " << clocks[Role::Black].remaining() << " s.\n";
+		history.play(board);
+		if (history.drawn()) {
+			std::cout << "The game is drawn by repetition or by king moves only.\n";
+			return 0;
+		}
 	}
 	std::cout << "The " << (board.color() == Role::Black ? "White" : "Black") << " has won.\n";
 	return 0;
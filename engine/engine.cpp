@@ -0,0 +1,266 @@
+#include "../board/board_state.h"
+#include "../board/engine.h"
+#include "../board/history.h"
+#include "../board/minimax.h"
+#include "../board/network.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Отдельный процесс для поиска ходов, управляемый строками на стандартном
+ * входе (по образцу UCI). Команды:
+ *   shashki                    — ответ "id name shashki-engine" и "shashkiok";
+ *   isready                    — ответ "readyok";
+ *   newgame                    — прервать поиск и забыть накопленное движком;
+ *   setoption name threads|hash value N
+ *                              — число потоков поиска, размер таблицы в мегабайтах;
+ *   position startpos|<запись> [moves <ход> ...]
+ *                              — позиция в записи вида "W:WA1,KC3:BH8" и ходы
+ *                                после неё в записи вида "C3-D4" или "C3:E5:G3";
+ *                                по этим ходам распознаются повторения позиций;
+ *   go [depth N] [movetime MS] [nodes N] [infinite] [ponder]
+ *      [wtime MS btime MS [winc MS binc MS] [movestogo N]]
+ *                              — начать поиск; без ограничений — на глубину
+ *                                minimax(); с часами (остаток, добавка
+ *                                и ходы до контроля) время хода выбирает
+ *                                сам движок; по ходу поиска выводятся строки
+ *                                "info depth D score S nodes N time MS pv ...",
+ *                                в конце — "bestmove <ход> [ponder <ответ>]"
+ *                                или "bestmove none"; с ponder позиция
+ *                                обдумывается на времени соперника после
+ *                                ожидаемого ответа, и ограничения действуют
+ *                                только после ponderhit; с infinite bestmove
+ *                                выводится только после stop, с ponder —
+ *                                не раньше ponderhit или stop;
+ *   ponderhit                  — соперник сыграл ожидаемый ответ: обдумывание
+ *                                становится обычным поиском;
+ *   stop                       — прервать поиск и сразу выдать лучший ход;
+ *   quit                       — выйти.
+ * Оценка S — отношение сил белых к силам чёрных, как у evaluate().
+ */
+
+namespace {
+
+class Session {
+public:
+	Session () : _board(BoardState::initialBoard()), _stop(false), _ponder(false) {}
+	~Session () {finish();}
+
+	bool execute (const std::string &line) {
+		std::istringstream in(line);
+		std::string command;
+		if (!(in >> command))
+			return true;
+		if (command == "shashki") {
+			say("id name shashki-engine");
+			say("shashkiok");
+		}
+		else if (command == "isready")
+			say("readyok");
+		else if (command == "newgame") {
+			finish();
+			_engine.clear();
+		}
+		else if (command == "setoption")
+			option(in);
+		else if (command == "position")
+			position(in);
+		else if (command == "go")
+			go(in);
+		else if (command == "stop")
+			finish();
+		else if (command == "ponderhit")
+			_wakeup.set(_ponder, false);
+		else if (command == "quit")
+			return false;
+		else
+			say("info string unknown command " + command);
+		return true;
+	}
+
+private:
+	void say (const std::string &text) {
+		std::lock_guard<std::mutex> lock(_output);
+		std::cout << text << std::endl;
+	}
+
+	// Прервать поиск, если он идёт, и дождаться его ответа.
+	void finish () {
+		if (!_thread.joinable())
+			return;
+		_wakeup.set(_stop, true);
+		_thread.join();
+	}
+
+	void option (std::istringstream &in) {
+		finish();
+		std::string word, name, value;
+		while (in >> word) {
+			if (word == "name")
+				in >> name;
+			else if (word == "value")
+				in >> value;
+		}
+		Engine::Config config = _engine.config();
+		if (name == "threads")
+			config.threads = std::max(1, std::atoi(value.c_str()));
+		else if (name == "hash")
+			config.hash = std::max(0, std::atoi(value.c_str()));
+		else {
+			say("info string unknown option " + name);
+			return;
+		}
+		_engine.configure(config);
+	}
+
+	void position (std::istringstream &in) {
+		finish();
+		std::string word;
+		in >> word;
+		BoardState board = word == "startpos" ? BoardState::initialBoard() : BoardState::fromString(word);
+		if (!board.color().valid()) {
+			say("info string bad position " + word);
+			return;
+		}
+		History history(board);
+		if (in >> word && word == "moves")
+			while (in >> word) {
+				std::vector<Cell> move = action(board, word);
+				if (move.empty()) {
+					say("info string illegal move " + word);
+					return;
+				}
+				BoardState::apply(board, move);
+				history.play(board);
+			}
+		_board = board;
+		_history = history;
+	}
+
+	void go (std::istringstream &in) {
+		finish();
+		Limits limits;
+		double time[2] = {0.0, 0.0}, increment[2] = {0.0, 0.0};
+		bool ponder = false, infinite = false;
+		std::string word, value;
+		while (in >> word) {
+			if (word == "depth" && in >> word)
+				limits.depth = std::atoi(word.c_str());
+			else if (word == "movetime" && in >> word)
+				limits.time = std::atof(word.c_str()) / 1000.0;
+			else if (word == "nodes" && in >> word)
+				limits.nodes = std::strtoull(word.c_str(), nullptr, 10);
+			else if (word == "infinite") {
+				limits.depth = std::numeric_limits<int>::max();
+				infinite = true;
+			}
+			else if (word == "ponder")
+				ponder = true;
+			else if ((word == "wtime" || word == "btime") && in >> value)
+				time[word == "btime" ? Role::Black : Role::White] = std::atof(value.c_str()) / 1000.0;
+			else if ((word == "winc" || word == "binc") && in >> value)
+				increment[word == "binc" ? Role::Black : Role::White] = std::atof(value.c_str()) / 1000.0;
+			else if (word == "movestogo" && in >> word)
+				limits.moves = std::atoi(word.c_str());
+		}
+		if (_board.color().valid()) {
+			limits.clock = time[_board.color()];
+			limits.increment = increment[_board.color()];
+		}
+		_stop = false;
+		_ponder = ponder;
+		limits.stop = &_stop;
+		limits.ponder = &_ponder;
+		limits.wakeup = &_wakeup;
+		limits.history = &_history;
+		BoardState board = _board;
+		_thread = std::thread([this, board, limits, infinite] {think(board, limits, infinite);});
+	}
+
+	void think (BoardState board, Limits limits, bool infinite) {
+		std::vector<std::vector<Cell>> expected;
+		std::vector<Cell> best = _engine.search(board, limits, [this, &board, &expected](const Progress &progress) {
+			std::ostringstream out;
+			out << "info depth " << progress.depth << " score " << std::fixed << std::setprecision(4)
+			    << progress.best.score << " nodes " << progress.nodes
+			    << " time " << static_cast<long long>(progress.time * 1000.0) << " pv";
+			BoardState line = board;
+			for (const std::vector<Cell> &move : progress.best.line) {
+				out << ' ' << line.notation(move);
+				BoardState::apply(line, move);
+			}
+			say(out.str());
+			expected = progress.best.line;
+		});
+		// Поиск мог кончиться раньше, чем его разрешено прервать: ответ ждёт stop или ponderhit.
+		{
+			std::unique_lock<std::mutex> lock(_wakeup.mutex);
+			_wakeup.changed.wait(lock, [this, infinite] {return _stop || (!infinite && !_ponder);});
+		}
+		if (best.empty()) {
+			say("bestmove none");
+			return;
+		}
+		std::string answer = "bestmove " + board.notation(best);
+		if (expected.size() > 1 && expected[0] == best) {
+			BoardState after = board;
+			BoardState::apply(after, best);
+			answer += " ponder " + after.notation(expected[1]);
+		}
+		say(answer);
+	}
+
+
+private:
+	Engine _engine;
+	BoardState _board;
+	History _history;    // Ходы после заданной позиции, для распознавания повторений.
+	std::atomic<bool> _stop;
+	std::atomic<bool> _ponder;    // Идёт обдумывание на времени соперника.
+	std::thread _thread;
+	std::mutex _output;
+	Wakeup _wakeup;      // Изменились _stop или _ponder.
+};
+
+}
+
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if (arg == "--network" && i+1 < argc) {
+			std::shared_ptr<const Network> network = Network::load(argv[++ i]);
+			if (!network) {
+				std::cerr << "Cannot load the network from " << argv[i] << '\n';
+				return 1;
+			}
+			useNetwork(network);
+		}
+		else if (arg == "--weights" && i+1 < argc) {
+			Weights weights;
+			if (!weights.load(argv[++ i])) {
+				std::cerr << "Cannot load weights from " << argv[i] << '\n';
+				return 1;
+			}
+			useWeights(weights);
+		}
+		else {
+			std::cerr << "Usage: shashki-engine [--network FILE] [--weights FILE]\n";
+			return 1;
+		}
+	}
+	Session session;
+	std::string line;
+	while (std::getline(std::cin, line))
+		if (!session.execute(line))
+			break;
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include "autoplay.h"
+#include "../board/engine.h"
+#include <algorithm>
+
+const int MaxPlies = 300;    // Партия без победителя прекращается на этом полуходе.
+const int Depth = 8;         // Глубина поиска, как у minimax().
+
+Autoplay::Autoplay() : _stop(false), _playing(0) {}
+
+Autoplay::~Autoplay() {stop();}
+
+void Autoplay::start(const QList<QPair<int, History>> &games, const Clock &control) {
+	stop();
+	_stop = false;
+	_moves.clear();
+	int count = std::min<int>(games.size(), std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<QList<QPair<int, History>>> shares(count);
+	for (int i = 0; i < games.size(); ++ i)
+		shares[i % count].append(games[i]);
+	_playing = count;
+	for (int i = 0; i < count; ++ i)
+		_threads.emplace_back(&Autoplay::play, this, shares[i], control);
+}
+
+void Autoplay::stop() {
+	_stop = true;
+	for (std::thread &thread : _threads)
+		thread.join();
+	_threads.clear();
+}
+
+bool Autoplay::running() const {return _playing > 0;}
+
+QList<QPair<int, std::vector<Cell>>> Autoplay::take() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	QList<QPair<int, std::vector<Cell>>> moves = _moves;
+	_moves.clear();
+	return moves;
+}
+
+void Autoplay::play(QList<QPair<int, History>> games, Clock control) {
+	Engine engine;
+	std::vector<int> plies(games.size(), 0);
+	std::vector<Clock> clocks(2*games.size(), control);
+	std::vector<bool> over(games.size(), false);
+	bool more = true;
+	while (more && !_stop) {
+		more = false;
+		for (int i = 0; i < games.size() && !_stop; ++ i) {
+			History &history = games[i].second;
+			BoardState board = history.board();
+			if (over[i] || board.lost() || history.drawn() || plies[i] >= MaxPlies)
+				continue;
+			Clock &clock = clocks[2*i + board.color()];
+			Limits limits;
+			limits.depth = clock.enabled() ? 0 : Depth;
+			limits.stop = &_stop;
+			limits.history = &history;
+			clock.start();
+			clock.limit(limits);
+			std::vector<Cell> action = engine.search(board, limits);
+			if (_stop)
+				break;
+			if (action.empty() || !clock.stop()) {    // эта партия кончена, остальные продолжаются
+				over[i] = true;
+				continue;
+			}
+			BoardState::apply(board, action);
+			history.play(board);
+			++ plies[i];
+			more = true;
+			std::lock_guard<std::mutex> lock(_mutex);
+			_moves.append(qMakePair(games[i].first, action));
+		}
+	}
+	-- _playing;
+}
@@ -0,0 +1,47 @@
+#ifndef AUTOPLAY_H
+#define AUTOPLAY_H
+
+#include "../board/board_state.h"
+#include "../board/cell.h"
+#include "../board/clock.h"
+#include "../board/history.h"
+#include <QList>
+#include <QPair>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Партии движка с самим собой в фоновых потоках. Каждая партия идёт
+ * в своей ветви дерева игры; найденные ходы копятся здесь, и окно
+ * забирает их пачкой с ограниченной частотой кадров, а не после
+ * каждого полухода. Потоков не больше, чем ядер; поток ведёт свои
+ * партии по очереди, по ходу в каждой, с одним движком на все.
+ * С контролем времени у каждой партии свои часы, и партия, в которой
+ * у стороны вышло время, прекращается; ничья по повторению или по ходам
+ * одними дамками тоже заканчивает партию.
+ */
+
+class Autoplay {
+public:
+	Autoplay();
+	~Autoplay();
+	void start(const QList<QPair<int, History>> &games,    // Номер ветви и партия в ней.
+	           const Clock &control = Clock());
+	void stop();
+	bool running() const;    // Ещё не все партии закончены.
+	QList<QPair<int, std::vector<Cell>>> take();    // Накопленные ходы: номер ветви и ход.
+private:
+	Autoplay(const Autoplay&) = delete;
+	Autoplay& operator=(const Autoplay&) = delete;
+	void play(QList<QPair<int, History>> games, Clock control);
+private:
+	std::vector<std::thread> _threads;
+	std::mutex _mutex;    // Защищает _moves.
+	QList<QPair<int, std::vector<Cell>>> _moves;
+	std::atomic<bool> _stop;
+	std::atomic<int> _playing;    // Потоки, у которых остались неоконченные партии.
+};
+
+#endif
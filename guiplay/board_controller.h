@@ -3,11 +3,10 @@
 
 #include <QObject>
 #include <QList>
-#include <memory>
 #include "../board/cell.h"
 #include "../board/board_state.h"
 #include "board_widget.h"
-#include "root.h"
+#include "move_tree.h"
 
 class BoardController : public QObject {
 	Q_OBJECT
@@ -22,16 +21,15 @@ public:
 signals:
 	void moved(std::vector<Cell> action);
 private:
-	std::shared_ptr<Root<Cell>> makeRoot(Cell at) const;
-	QList<Cell> readAction(Root<Cell>::Iterator head) const;
-	QList<Root<Cell>::Iterator> restrictHeads(Cell at) const;
-	QList<Cell> commonPrefix(QList<Root<Cell>::Iterator> heads, Cell at) const;
+	void prepareHover() const;
 private:
 	BoardWidget *_control;
 	BoardState _board;
-	std::shared_ptr<Root<Cell>> _move;
-	QList<Root<Cell>::Iterator> _heads;
+	MoveTree _tree;    // Все ходы из позиции _board.
+	int _start;        // Вершина в _tree начального поля хода или -1.
 	int _count;
+	mutable bool _prepared;          // Подсветка ниже соответствует текущему выбору.
+	mutable QList<Cell> _blue[32];   // Синяя подсветка при указателе над каждым полем.
 };
 
 #endif
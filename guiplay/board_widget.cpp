@@ -1,7 +1,9 @@
 #include "board_widget.h"
 #include "board_controller.h"
+#include "../board/stock.h"
 #include <QMouseEvent>
 #include <QKeyEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QFont>
 
@@ -27,16 +29,42 @@ void BoardWidget::setController(BoardController *controller) {
 
 const Position& BoardWidget::position() const {return _position;}
 Position& BoardWidget::position() {return _position;}
-void BoardWidget::setPosition(const Position &position) {_position = position; update();}
-void BoardWidget::setFlipped(bool is) {_flipped = is; update();}
+void BoardWidget::setFlipped(bool is) {_flipped = is; _background = QPixmap(); update();}
 bool BoardWidget::flipped() const {return _flipped;}
 void BoardWidget::setActive(bool is) {_active = is; update();}
 bool BoardWidget::active() const {return _active;}
 
-void BoardWidget::markBlue(QList<Cell> blue) {_blue = blue; update();}
-void BoardWidget::markGreen(QList<Cell> green) {_green = green; update();}
-void BoardWidget::markBorder(Cell border) {_border = border; update();}
-void BoardWidget::unmark() {_blue.clear(); _green.clear(); _border = Cell(); update();}
+void BoardWidget::setPosition(const Position &position) {
+	std::uint32_t changed = 0;
+	for (int color = Role::White; color <= Role::Black; ++ color)
+		changed |= _position.mask(color) ^ position.mask(color);
+	changed |= _position.kings() ^ position.kings();
+	_position = position;
+	for (Cell cell : Stock(changed))
+		update(cellRect(cell));
+}
+
+void BoardWidget::markBlue(QList<Cell> blue) {
+	updateCells(_blue + blue);
+	_blue = blue;
+}
+
+void BoardWidget::markGreen(QList<Cell> green) {
+	updateCells(_green + green);
+	_green = green;
+}
+
+void BoardWidget::markBorder(Cell border) {
+	updateCells(QList<Cell>() << _border << border);
+	_border = border;
+}
+
+void BoardWidget::unmark() {
+	updateCells(_blue + _green + (QList<Cell>() << _border));
+	_blue.clear();
+	_green.clear();
+	_border = Cell();
+}
 
 QList<Cell> BoardWidget::green() const {return _green;}
 QList<Cell> BoardWidget::blue() const {return _blue;}
@@ -66,8 +94,51 @@ void BoardWidget::mouseMoveEvent(QMouseEvent *e) {
 	}
 }
 
-void BoardWidget::paintEvent(QPaintEvent *) {
+void BoardWidget::resizeEvent(QResizeEvent *) {_background = QPixmap();}
+
+/*
+ * Поля и подписи меняются только при изменении размера или переворачивании
+ * доски, поэтому они рисуются заранее на картинку с разрешением экрана.
+ * Поверх неё рисуются лишь поля, попавшие в обновляемую область.
+ */
+void BoardWidget::paintEvent(QPaintEvent *e) {
+	qreal ratio = devicePixelRatioF();
+	if (_background.isNull() || _background.size() != size() * ratio)
+		renderBackground();
 	QPainter painter(this);
+	painter.drawPixmap(e->rect(), _background, QRectF(QPointF(e->rect().topLeft()) * ratio,
+	                                                  QSizeF(e->rect().size()) * ratio));
+	painter.setViewport(makeViewport());
+	painter.setWindow(-50, -50, 900, 900);
+	for (int row = 0; row < 8; ++ row)
+		for (int col = 0; col < 8; ++ col) {
+			Cell cell = makeCell(col, row);
+			if (!cell.valid() || !e->region().intersects(cellRect(cell)))
+				continue;
+			drawMarks(painter, row, col);
+			if (_position.color(cell) != Role::None)
+				drawStone(painter, QPoint(col*100 + 50, row*100 + 50), cell);
+		}
+	if (_border.valid()) {
+		int row = _flipped ? _border.rank() : 7-_border.rank();
+		int col = _flipped ? 7-_border.file() : _border.file();
+		painter.setPen(QPen(_env.BorderBrush, 5));
+		painter.setBrush(Qt::NoBrush);
+		painter.drawRect(col*100, row*100, 100, 100);
+	}
+	if (!_active) {
+		painter.setPen(QPen());
+		painter.setBrush(_env.ShadowBrush);
+		painter.drawRect(0, 0, 800, 800);
+	}
+}
+
+void BoardWidget::renderBackground() {
+	qreal ratio = devicePixelRatioF();
+	_background = QPixmap(size() * ratio);
+	_background.setDevicePixelRatio(ratio);
+	_background.fill(Qt::transparent);
+	QPainter painter(&_background);
 	painter.setViewport(makeViewport());
 	painter.setWindow(-50, -50, 900, 900);
 	painter.setFont(_env.LabelFont);
@@ -80,40 +151,30 @@ void BoardWidget::paintEvent(QPaintEvent *) {
 		int rank = _flipped ? row : 7-row;
 		painter.drawText(-50, row*100, 50, 100, Qt::AlignCenter, QString(1, rank+'1'));
 		painter.drawText(800, row*100, 50, 100, Qt::AlignCenter, QString(1, rank+'1'));
-		for (int col = 0; col < 8; ++ col) {
-			int file = _flipped ? 7-col : col;
-			Cell cell(file, rank);
+		for (int col = 0; col < 8; ++ col)
 			drawSquare(painter, row, col);
-			if (_position.color(cell) != Role::None)
-				drawStone(painter, QPoint(col*100 + 50, row*100 + 50), cell);
-		}
-	}
-	if (!_active) {
-		painter.setBrush(_env.ShadowBrush);
-		painter.drawRect(0, 0, 800, 800);
 	}
 }
 
 void BoardWidget::drawSquare(QPainter &painter, int row, int col) {
-    Cell cell = makeCell(col, row);
 	painter.save();
 	painter.setBrush(((row+col)%2 == 1) ? _env.BlackSquareBrush : _env.WhiteSquareBrush);
-	if (cell == _border && cell.valid())
-		painter.setPen(QPen(_env.BorderBrush, 5));
-	else
-		painter.setPen(QPen());
+	painter.setPen(QPen());
 	painter.drawRect(col*100, row*100, 100, 100);
+	painter.restore();
+}
 
+void BoardWidget::drawMarks(QPainter &painter, int row, int col) {
+	Cell cell = makeCell(col, row);
+	painter.save();
 	painter.setPen(QPen());
-	if (cell.valid()) {
-		if (_blue.contains(cell)) {
-			painter.setBrush(_env.BlueBrush);
-			painter.drawRect(col*100, row*100, 100, 100);
-		}
-		else if (_green.contains(cell)) {
-			painter.setBrush(_env.GreenBrush);
-			painter.drawRect(col*100, row*100, 100, 100);
-		}
+	if (_blue.contains(cell)) {
+		painter.setBrush(_env.BlueBrush);
+		painter.drawRect(col*100, row*100, 100, 100);
+	}
+	else if (_green.contains(cell)) {
+		painter.setBrush(_env.GreenBrush);
+		painter.drawRect(col*100, row*100, 100, 100);
 	}
 	painter.restore();
 }
@@ -154,6 +215,22 @@ Cell BoardWidget::locate(QPoint pos) const {
     return makeCell(pos.x()/100, pos.y()/100);
 }
 
+// Область поля на виджете вместе с рамочкой, выступающей за его край.
+QRect BoardWidget::cellRect(Cell cell) const {
+	QRect viewport = makeViewport();
+	int row = _flipped ? cell.rank() : 7-cell.rank();
+	int col = _flipped ? 7-cell.file() : cell.file();
+	qreal scale = viewport.height() / 900.0;
+	QRectF area((col*100 + 50 - 3) * scale, (row*100 + 50 - 3) * scale, 106 * scale, 106 * scale);
+	return area.translated(viewport.topLeft()).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+void BoardWidget::updateCells(const QList<Cell> &cells) {
+	for (Cell cell : cells)
+		if (cell.valid())
+			update(cellRect(cell));
+}
+
 Cell BoardWidget::makeCell(int col, int row) const {
     int rank = _flipped ? row : 7-row;
     int file = _flipped ? 7-col : col;
@@ -5,6 +5,7 @@
 #include <QList>
 #include <QRect>
 #include <QPen>
+#include <QPixmap>
 #include "../board/position.h"
 #include "../board/cell.h"
 
@@ -35,10 +36,15 @@ protected:
 	void mousePressEvent(QMouseEvent *e);
 	void mouseMoveEvent(QMouseEvent *e);
 	void paintEvent(QPaintEvent *e);
+	void resizeEvent(QResizeEvent *e);
 private:
 	QRect makeViewport() const;
 	Cell locate(QPoint pos) const;
+	QRect cellRect(Cell cell) const;
+	void updateCells(const QList<Cell> &cells);
+	void renderBackground();
 	void drawSquare(QPainter& painter, int row, int col);
+	void drawMarks(QPainter& painter, int row, int col);
 	void drawStone(QPainter& painter, QPoint centre, Cell cell);
     Cell makeCell(int col, int row) const;
 private:
@@ -65,6 +71,7 @@ private:
 	bool _flipped;  // «изображение доски перевёрнуто»
 	bool _active;   // «изображение доски активно»
 	Cell _hover;    // уже был отправлен сигнал, что указатель мыши над полем
+	QPixmap _background;    // поля и подписи без шашек и пометок; пуст, если устарел
 };
 
 #endif
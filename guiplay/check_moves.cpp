@@ -0,0 +1,269 @@
+#include "move_tree.h"
+#include "root.h"
+#include "../board/minimax.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Сверка MoveTree::choose() с прежним выбором хода в BoardController,
+ * который строил дерево ходов на доске (makeRoot), отбирал ходы через
+ * нажатое поле (restrictHeads) и брал их общее начало (commonPrefix).
+ *
+ * На позициях из случайных партий для каждого начального поля, каждого
+ * поля, на которое можно нажать, и каждого числа уже выбранных полей,
+ * до которого доходит выбор, оба способа должны дать одни и те же поля
+ * с теми же признаками взятия. Отдельно считаются ходы, в которых дамка
+ * проходит одно поле дважды: на них прежний и новый способы расходились
+ * бы прежде всего.
+ */
+
+namespace {
+
+std::vector<Cell> convertArray(QList<Cell> in) {
+	std::vector<Cell> out;
+	for (Cell cell : in)
+		out.push_back(cell);
+	return out;
+}
+
+// Прежний выбор хода, без отметок на доске.
+class Reference {
+public:
+	Reference(const BoardState &board) : _board(board) {}
+
+	// Составить дерево ходов; источник — начальный ход; вершины — завершения хода.
+	bool makeRoot(Cell at) {
+		BoardState test = _board;
+		if (!test.control(at))
+			return false;
+		_move.reset(new Root<Cell>(at));
+		bool empty;
+		do {
+			empty = true;
+			for (Root<Cell>::Iterator head : _move->heads()) {
+				BoardState board = _board;
+				BoardState::apply(board, convertArray(_move->makeList(head)));
+				Cell cell = (*_move)[head];
+				if (cell.valid()) {
+					for (Direction d : Direction::enumerate()) {
+						BoardState copy = board;
+						Cell next = cell.neighbour(d);
+						if (copy.control(next)) {
+							next.setCapture(copy.capture());
+							_move->appendHead(head, next);
+						}
+					}
+					if (board.control(Cell()))
+						_move->appendHead(head, Cell());
+					_move->unmarkHead(head);
+					empty = false;
+					break;
+				}
+			}
+		} while (!empty);
+		return !_move->heads().empty();
+	}
+
+	// Ходы через поле at дальше count-го поля за наименьшее число взятий до at.
+	QList<Root<Cell>::Iterator> restrictHeads(int count, Cell at) const {
+		QList<Root<Cell>::Iterator> heads;
+		QList<int> counts;
+		for (Root<Cell>::Iterator head : _move->heads()) {
+			QList<Cell> action = _move->makeList(head);
+			int taken = 0;
+			for (int i = 0; i < action.size() && action[i] != at; ++ i)
+				taken += action[i].capture();
+			if (count < action.size() && !action[count].valid() && action[count-1] == at) {
+				heads.append(head);
+				counts.append(taken);
+			}
+			for (int i = count; i < action.size(); ++ i)
+				if (action[i] == at) {
+					heads.append(head);
+					counts.append(taken);
+				}
+		}
+		int least = -1;
+		for (int taken : counts)
+			if (least < 0 || taken < least)
+				least = taken;
+		QList<Root<Cell>::Iterator> result;
+		for (int i = 0; i < heads.size(); ++ i)
+			if (counts[i] == least)
+				result.append(heads[i]);
+		return result;
+	}
+
+	// Общее начало ходов; завершение хода, если на at можно закончить.
+	QList<Cell> commonPrefix(QList<Root<Cell>::Iterator> heads, Cell at) const {
+		QList<Cell> prefix;
+		for (Root<Cell>::Iterator head : heads) {
+			QList<Cell> action = _move->makeList(head);
+			if (prefix.isEmpty())
+				prefix = action;
+			else {
+				int i = 0;
+				while (i < prefix.size() && i < action.size() && prefix[i] == action[i])
+					++ i;
+				bool stop = false;
+				if (prefix[i-1] == at) {
+					if (i < prefix.size() && !prefix[i].valid())
+						stop = true;
+					if (i < action.size() && !action[i].valid())
+						stop = true;
+				}
+				prefix.erase(prefix.begin()+i, prefix.end());
+				if (stop) {
+					prefix.append(Cell());
+					break;
+				}
+			}
+		}
+		return prefix;
+	}
+
+private:
+	BoardState _board;
+	std::shared_ptr<Root<Cell>> _move;
+};
+
+std::string show(const QList<Cell> &cells) {
+	std::string result;
+	for (Cell cell : cells)
+		result += (result.empty() ? "" : " ") + (cell.valid() ? cell.str() : std::string("end"))
+		          + (cell.capture() ? "x" : "");
+	return result.empty() ? "(none)" : result;
+}
+
+bool same(const QList<Cell> &a, const QList<Cell> &b) {
+	if (a.size() != b.size())
+		return false;
+	for (int i = 0; i < a.size(); ++ i)
+		if (a[i] != b[i] || a[i].capture() != b[i].capture())
+			return false;
+	return true;
+}
+
+// Ход проходит какое-то поле дважды.
+bool revisits(const std::vector<Cell> &action) {
+	std::uint32_t seen = 0;
+	for (Cell cell : action) {
+		if (!cell.valid())
+			continue;
+		std::uint32_t bit = 1u << cell.index();
+		if (seen & bit)
+			return true;
+		seen |= bit;
+	}
+	return false;
+}
+
+struct Totals {
+	unsigned long positions = 0;
+	unsigned long choices = 0;
+	unsigned long revisiting = 0;    // Ходов, проходящих поле дважды.
+};
+
+// Все начальные поля и все достижимые числа выбранных полей одной позиции.
+bool check(const BoardState &board, Totals &totals) {
+	++ totals.positions;
+	for (const std::vector<Cell> &action : explore(board))
+		totals.revisiting += revisits(action);
+	MoveTree tree(board);
+	for (unsigned int index = 0; index < 32; ++ index) {
+		Cell from = Cell::fromIndex(index);
+		Reference reference(board);
+		int start = tree.start(from);
+		if (reference.makeRoot(from) != (start >= 0)) {
+			std::cout << "MISMATCH at " << board.str() << ": start " << from.str() << '\n';
+			return false;
+		}
+		if (start < 0)
+			continue;
+		std::vector<int> counts = {1};
+		std::set<int> seen = {1};
+		for (std::size_t next = 0; next < counts.size(); ++ next) {
+			int count = counts[next];
+			for (unsigned int target = 0; target < 32; ++ target) {
+				Cell at = Cell::fromIndex(target);
+				QList<Cell> expected = reference.commonPrefix(reference.restrictHeads(count, at), at);
+				QList<Cell> actual = tree.choose(start, count, at);
+				++ totals.choices;
+				if (!same(expected, actual)) {
+					std::cout << "MISMATCH at " << board.str() << ": from " << from.str() << ", " << count
+					          << " chosen, at " << at.str() << "\n  expected: " << show(expected)
+					          << "\n  actual:   " << show(actual) << '\n';
+					return false;
+				}
+				if (!actual.isEmpty() && actual.last().valid() && seen.insert(actual.size()).second)
+					counts.push_back(actual.size());
+			}
+		}
+	}
+	return true;
+}
+
+const char *Roots[] = {
+	"W:WA1,C1,E1,G1,B2,D2,F2,H2,A3,C3,E3,G3:BB6,D6,F6,H6,A7,C7,E7,G7,B8,D8,F8,H8",
+	"W:WKC1,E3,G3:BB4,D6,F6,B6,KH8",
+	"B:WKA1,C3,E3,C5,G5:BKH8,F6,B6,D8",
+	"W:WB6,F4,H2:BC7,E7,G5,E5,G3",
+	"W:WKA1:BC3,E3,C5,E5,C7,E7",
+};
+
+void usage() {
+	std::cerr << "Usage: guiplay_check [--games N] [--plies N] [--seed N]\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+	int games = 20, plies = 200;
+	unsigned int seed = 1;
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		bool more = i+1 < argc;
+		if (arg == "--games" && more)
+			games = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--plies" && more)
+			plies = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--seed" && more)
+			seed = std::strtoul(argv[++ i], nullptr, 10);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	Totals totals;
+	std::mt19937 random(seed);
+	for (const char *notation : Roots) {
+		BoardState root = BoardState::fromString(notation);
+		for (int game = 0; game <= games; ++ game) {
+			BoardState board = root;
+			for (int ply = 0; ply < plies; ++ ply) {
+				if (!check(board, totals))
+					return 1;
+				std::vector<std::vector<Cell>> actions = explore(board);
+				if (game == 0 || actions.empty())    // Нулевая партия — только сама начальная позиция.
+					break;
+				BoardState::apply(board, actions[random() % actions.size()]);
+			}
+		}
+	}
+	if (!totals.revisiting) {
+		std::cout << "No move passes a square twice; the check proves too little\n";
+		return 1;
+	}
+	std::cout << "OK: " << totals.positions << " positions, " << totals.choices << " choices, "
+	          << totals.revisiting << " moves through a square twice\n";
+	return 0;
+}
+
+#include "root.tpp"
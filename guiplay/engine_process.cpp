@@ -0,0 +1,138 @@
+#include "engine_process.h"
+#include "../board/minimax.h"
+
+const int MaxRestarts = 3;
+
+EngineProcess::EngineProcess(QString program, QStringList arguments, QObject *parent)
+	: QObject(parent), _process(new QProcess(this)), _program(program),
+	  _arguments(arguments), _pondering(false), _busy(false), _pending(0), _restarts(0) {
+	_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	using Finished = void (QProcess::*)(int, QProcess::ExitStatus);
+	connect(_process, &QProcess::readyReadStandardOutput, this, &EngineProcess::read);
+	connect(_process, static_cast<Finished>(&QProcess::finished), this, &EngineProcess::exited);
+	// Упавший процесс сообщает и об ошибке, и о завершении; перезапуск — только по завершению
+	// или по ошибке запуска, после которой завершения не будет.
+	connect(_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+		if (error == QProcess::FailedToStart)
+			exited();
+	});
+}
+
+EngineProcess::~EngineProcess() {
+	if (_process->state() == QProcess::NotRunning)
+		return;
+	_process->write("quit\n");
+	if (!_process->waitForFinished(1000))
+		_process->kill();
+}
+
+// Позиция после ходов moves от origin.
+BoardState play(BoardState origin, const std::vector<std::vector<Cell>> &moves) {
+	for (const std::vector<Cell> &action : moves)
+		BoardState::apply(origin, action);
+	return origin;
+}
+
+void EngineProcess::request(BoardState origin, std::vector<std::vector<Cell>> moves, Limits limits) {
+	BoardState board = play(origin, moves);
+	bool hit = _pondering && board.str() == _board.str();
+	_pondering = false;
+	_start = origin;
+	_moves = moves;
+	_board = board;
+	_limits = limits;
+	_busy = true;
+	if (_process->state() == QProcess::NotRunning)
+		start();
+	else if (hit)    // ответ на обдумывание и будет ответом на запрос
+		_process->write("ponderhit\n");
+	else
+		send();
+}
+
+void EngineProcess::ponder(BoardState origin, std::vector<std::vector<Cell>> moves, Limits limits) {
+	BoardState board = play(origin, moves);
+	if (_process->state() == QProcess::NotRunning || _busy || _reply.empty()
+	    || board.str() != _expected.str())
+		return;
+	BoardState::apply(board, _reply);
+	moves.push_back(_reply);
+	_start = origin;
+	_moves = moves;
+	_board = board;
+	_limits = limits;
+	_pondering = true;
+	send(true);
+}
+
+void EngineProcess::start() {
+	_pending = 0;
+	_pondering = false;
+	_process->start(_program, _arguments);
+	send();
+}
+
+void EngineProcess::send(bool ponder) {
+	QByteArray command = "position ";
+	command += QByteArray::fromStdString(_start.str());
+	if (!_moves.empty()) {
+		command += " moves";
+		BoardState board = _start;
+		for (const std::vector<Cell> &action : _moves) {
+			command += " " + QByteArray::fromStdString(board.notation(action));
+			BoardState::apply(board, action);
+		}
+	}
+	command += ponder ? "\ngo ponder" : "\ngo";
+	if (_limits.clock > 0.0) {
+		QByteArray side = _board.color() == Role::White ? "w" : "b";
+		command += " " + side + "time " + QByteArray::number(qRound64(_limits.clock * 1000.0));
+		command += " " + side + "inc " + QByteArray::number(qRound64(_limits.increment * 1000.0));
+		if (_limits.moves)
+			command += " movestogo " + QByteArray::number(_limits.moves);
+	}
+	command += "\n";
+	_process->write(command);
+	++ _pending;
+}
+
+// Новая позиция прерывает прежний поиск, но ответ на него всё равно
+// приходит; годится только ответ на последний запрос.
+void EngineProcess::read() {
+	while (_process->canReadLine()) {
+		QString line = QString::fromUtf8(_process->readLine()).trimmed();
+		if (!line.startsWith("bestmove ") || -- _pending > 0 || !_busy)
+			continue;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+		QStringList words = line.split(' ', Qt::SkipEmptyParts);
+#else
+		QStringList words = line.split(' ', QString::SkipEmptyParts);
+#endif
+		std::vector<Cell> found = action(_board, words.value(1).toStdString());
+		_busy = false;
+		if (found.empty()) {
+			qWarning("The engine %s has answered with %s", qPrintable(_program), qPrintable(line));
+			emit failed();
+			continue;
+		}
+		_expected = _board;
+		BoardState::apply(_expected, found);
+		_reply.clear();
+		if (words.value(2) == "ponder")
+			_reply = action(_expected, words.value(3).toStdString());
+		_restarts = 0;
+		emit moved(found);
+	}
+}
+
+void EngineProcess::exited() {
+	if (!_busy || _process->state() != QProcess::NotRunning)
+		return;
+	if (_restarts ++ >= MaxRestarts) {
+		qWarning("The engine %s keeps failing: %s", qPrintable(_program), qPrintable(_process->errorString()));
+		_busy = false;
+		emit failed();
+		return;
+	}
+	start();
+}
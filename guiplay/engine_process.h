@@ -0,0 +1,54 @@
+#ifndef ENGINE_PROCESS_H
+#define ENGINE_PROCESS_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include "../board/board_state.h"
+#include "../board/cell.h"
+#include "../board/minimax.h"
+
+/*
+ * Поиск хода во внешнем процессе shashki-engine вместо потока в самом
+ * приложении. Процесс запускается при первом запросе; если он падает
+ * во время поиска, он перезапускается и запрос повторяется. Если хода
+ * так и не получено (процесс не запускается или отвечает не ходом),
+ * посылается сигнал failed. Ожидаемый ответ соперника на найденный ход
+ * процесс обдумывает заранее (ponder). Процессу передаётся не только
+ * позиция, но и ходы партии до неё, чтобы он распознавал повторения.
+ */
+
+class EngineProcess : public QObject {
+	Q_OBJECT
+public:
+	EngineProcess(QString program, QStringList arguments, QObject *parent = nullptr);
+	~EngineProcess();
+	// Ход ищется в позиции после moves от origin; ответ придёт сигналом moved или failed.
+	void request(BoardState origin, std::vector<std::vector<Cell>> moves, Limits limits = Limits());
+	void ponder(BoardState origin, std::vector<std::vector<Cell>> moves, Limits limits);    // moves кончаются найденным ходом.
+
+signals:
+	void moved(std::vector<Cell> action);
+	void failed();
+private:
+	void start();
+	void send(bool ponder = false);
+	void read();
+	void exited();
+private:
+	QProcess *_process;
+	QString _program;
+	QStringList _arguments;
+	BoardState _start;    // Начало партии...
+	std::vector<std::vector<Cell>> _moves;    // ...и ходы от него до позиции, для которой ищется ход.
+	BoardState _board;    // Сама эта позиция.
+	Limits _limits;       // Часы ходящего, если они есть.
+	BoardState _expected; // Позиция после последнего найденного хода...
+	std::vector<Cell> _reply;    // ...и ожидаемый в ней ответ.
+	bool _pondering;      // Обдумывается позиция _board после ожидаемого ответа.
+	bool _busy;           // Ответ на запрос ещё не получен.
+	int _pending;         // Число запросов, на которые процесс ещё не ответил.
+	int _restarts;        // Перезапуски подряд без единого ответа.
+};
+
+#endif
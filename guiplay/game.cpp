@@ -1,16 +1,58 @@
 #include "game.h"
 
-Game::Game() : _game(BoardState::initialBoard()) {}
+const int Interval = 32;     // Через столько полуходов позиция сохраняется целиком.
+const int CacheSize = 8;
+
+Game::Move::Move() : count(0) {}
+
+Game::Move::Move(const std::vector<Cell> &action) : count(0) {
+	Direction direction;
+	for (unsigned int i = 0; i < action.size() && action[i].valid(); ++ i) {
+		Direction next = i ? action[i-1].connection(action[i]) : Direction();
+		if (i > 1 && next != direction)
+			points[count ++] = action[i-1].index();
+		if (i == 0)
+			points[count ++] = action[i].index();
+		direction = next;
+	}
+	if (action.size() > 2)
+		points[count ++] = action[action.size()-2].index();
+}
+
+std::vector<Cell> Game::Move::action() const {
+	std::vector<Cell> result;
+	if (!count)
+		return result;
+	Cell at = Cell::fromIndex(points[0]);
+	result.push_back(at);
+	for (int i = 1; i < count; ++ i) {
+		Cell target = Cell::fromIndex(points[i]);
+		int df = target.file() > at.file() ? 1 : -1;
+		int dr = target.rank() > at.rank() ? 1 : -1;
+		while (at != target) {
+			at = Cell(at.file() + df, at.rank() + dr);
+			result.push_back(at);
+		}
+	}
+	result.push_back(Cell());
+	return result;
+}
+
+Game::Game() : _game(Node{Move(), 0}), _frames(1, BoardState::initialBoard()) {}
 
 bool Game::empty() const {
-	for (Root<BoardState>::Iterator it: _game.heads())
-		if (_game.makeList(it).size() > 1)
+	for (Tree::Iterator it: _game.heads())
+		if (_game.depth(it) > 0)
 			return false;
 	return true;
 }
 
+int Game::heads() const {
+	return _game.heads().size();
+}
+
 int Game::length(int head) const {
-	return _game.makeList(_game.heads()[head]).size();
+	return _game.depth(_game.heads()[head]) + 1;
 }
 
 bool Game::inner(int head, int depth) const {
@@ -24,45 +66,184 @@ bool Game::inner(int head, int depth) const {
 }
 
 BoardState Game::at(int head, int depth) const {
-	return _game[find(head, depth)];
+	return rebuild(find(head, depth));
 }
 
-void Game::fork(int head, int depth) {
-	_game.markHead(find(head, depth));
+int Game::fork(int head, int depth) {
+	auto at = find(head, depth);
+	_game.markHead(at);
+	return _game.heads().indexOf(at);
 }
 
-BoardState Game::cut(int head, int depth) {
+int Game::cut(int head, int depth) {
 	auto heads = _game.heads();
 	auto at = find(head, depth);
 	for(auto it : heads)
 		if (doesReach(at, it))
 			_game.unmarkHead(it);
 	_game.markHead(at);
-	return _game[at];
+	return _game.heads().indexOf(at);
 }
 
 BoardState Game::evolve(int head, std::vector<Cell> action) {
-	BoardState board = _game[_game.heads()[head]];
+	Tree::Iterator from = _game.heads()[head];
+	BoardState board = rebuild(from);
 	BoardState::apply(board, action);
-	board = _game[_game.appendHead(_game.heads()[head], board)];
-	_game.unmarkHead(_game.heads()[head]);
+	Tree::Iterator to = _game.extendHead(from, makeNode(from, board, action));
+	remember(to, board);
+	extend(from, to, board, false);
 	return board;
 }
 
-Root<BoardState>::Iterator Game::find(int head, int depth) const {
-	Root<BoardState>::Iterator it = _game.heads()[head];
-	for (int c = 0; c < depth; ++ c)
+int Game::branch(int head, std::vector<Cell> action) {
+	Tree::Iterator from = _game.heads()[head];
+	BoardState board = rebuild(from);
+	BoardState::apply(board, action);
+	Tree::Iterator to = _game.appendHead(from, makeNode(from, board, action));
+	remember(to, board);
+	extend(from, to, board, true);
+	return _game.heads().size()-1;
+}
+
+History Game::history(int head) const {
+	return track(_game.heads()[head]);
+}
+
+std::vector<std::vector<Cell>> Game::actions(int head) const {
+	QList<Node> path = _game.makeList(_game.heads()[head]);
+	std::vector<std::vector<Cell>> result;
+	for (int i = 1; i < path.size(); ++ i)
+		result.push_back(path[i].move.action());
+	return result;
+}
+
+bool Game::drawn(int head) const {
+	return track(_game.heads()[head]).drawn();
+}
+
+// Вершина для позиции board, полученной ходом action из from.
+Game::Node Game::makeNode(Tree::Iterator from, const BoardState &board, const std::vector<Cell> &action) {
+	Node node{Move(action), -1};
+	if ((_game.depth(from) + 1) % Interval == 0) {
+		node.frame = _frames.size();
+		_frames.push_back(board);
+	}
+	return node;
+}
+
+Game::Tree::Iterator Game::find(int head, int depth) const {
+	Tree::Iterator it = _game.heads()[head];
+	return _game.ancestorAt(it, _game.depth(it) - depth);
+}
+
+// Вершина from, кроме источника, лежит на пути от источника к to.
+bool Game::doesReach(Tree::Iterator from, Tree::Iterator to) const {
+	return !from.source() && _game.isAncestor(from, to);
+}
+
+// Позиция восстанавливается ходами от ближайшей сохранённой или недавней.
+BoardState Game::rebuild(Tree::Iterator at) const {
+	BoardState board;
+	std::vector<Tree::Iterator> path;
+	Tree::Iterator it = at;
+	while (!cached(it, board)) {
+		if (_game[it].frame >= 0) {
+			board = _frames[_game[it].frame];
+			break;
+		}
+		path.push_back(it);
 		it = _game.prev(it);
-	return it;
+	}
+	for (auto step = path.rbegin(); step != path.rend(); ++ step)
+		BoardState::apply(board, _game[*step].move.action());
+	remember(at, board);
+	return board;
 }
 
-bool Game::doesReach(Root<BoardState>::Iterator from, Root<BoardState>::Iterator to) const {
-	while (!to.source()) {
-		if (to == from)
+bool Game::cached(Tree::Iterator at, BoardState &board) const {
+	for (int i = 0; i < _cache.size(); ++ i)
+		if (_cache[i].first == at) {
+			board = _cache[i].second;
 			return true;
-		to = _game.prev(to);
-	}
+		}
 	return false;
 }
 
+void Game::remember(Tree::Iterator at, const BoardState &board) const {
+	for (int i = 0; i < _cache.size(); ++ i)
+		if (_cache[i].first == at) {
+			_cache.move(i, 0);
+			return;
+		}
+	_cache.prepend(qMakePair(at, board));
+	if (_cache.size() > CacheSize)
+		_cache.removeLast();
+}
+
+// История ветви с последней вершиной head; собирается ходами от начала один раз.
+const History& Game::track(Tree::Iterator head) const {
+	for (int i = 0; i < _histories.size(); ++ i)
+		if (_histories[i].first == head)
+			return _histories[i].second;
+	QList<Tree::Iterator> heads = _game.heads();
+	for (int i = _histories.size()-1; i >= 0; -- i)    // Ветви, убранные cut().
+		if (!heads.contains(_histories[i].first))
+			_histories.removeAt(i);
+	QList<Node> path = _game.makeList(head);
+	BoardState board = _frames[0];
+	History result(board);
+	for (int i = 1; i < path.size(); ++ i) {
+		BoardState::apply(board, path[i].move.action());
+		result.play(board);
+	}
+	_histories.append(qMakePair(head, result));
+	return _histories.last().second;
+}
+
+Clock& Game::clock(int head, Role color) {
+	Tree::Iterator it = _game.heads()[head];
+	for (Clocks &clocks : _clocks)
+		if (clocks.head == it)
+			return clocks.sides[color];
+	QList<Tree::Iterator> heads = _game.heads();
+	for (int i = _clocks.size()-1; i >= 0; -- i)    // Ветви, убранные cut().
+		if (!heads.contains(_clocks[i].head))
+			_clocks.removeAt(i);
+	_clocks.append(Clocks{it, {_control, _control}});
+	return _clocks.last().sides[color];
+}
+
+void Game::setClocks(const Clock &control) {
+	_control = control;
+	_clocks.clear();
+}
+
+void Game::pauseClocks() {
+	for (Clocks &clocks : _clocks)
+		for (Clock &clock : clocks.sides)
+			clock.pause();
+}
+
+// Ветвь продолжена из from в to позицией board; с keep история и часы from остаются и у своей ветви.
+void Game::extend(Tree::Iterator from, Tree::Iterator to, const BoardState &board, bool keep) {
+	for (int i = 0; i < _clocks.size(); ++ i)
+		if (_clocks[i].head == from) {
+			if (keep)
+				_clocks.append(Clocks{to, {_clocks[i].sides[0], _clocks[i].sides[1]}});
+			else
+				_clocks[i].head = to;
+			break;
+		}
+	for (int i = 0; i < _histories.size(); ++ i)
+		if (_histories[i].first == from) {
+			History history = _histories[i].second;
+			history.play(board);
+			if (keep)
+				_histories.append(qMakePair(to, history));
+			else
+				_histories[i] = qMakePair(to, history);
+			return;
+		}
+}
+
 #include "root.tpp"
@@ -3,23 +3,75 @@
 
 #include "../board/cell.h"
 #include "../board/board_state.h"
+#include "../board/history.h"
+#include "../board/clock.h"
 #include "root.h"
+#include <QList>
+#include <QPair>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Дерево игры. В вершинах хранятся только ходы в сжатом виде; позиция
+ * восстанавливается от ближайшей сохранённой целиком предшествующей позиции
+ * (такой бывает каждая Interval-я по глубине), а несколько недавно
+ * восстановленных позиций держатся наготове. История позиций каждой
+ * ветви собирается один раз и дальше продолжается вместе с ветвью;
+ * так же с ветвью идут и её часы.
+ */
 
 class Game {
 public:
 	Game();
 	bool empty() const;
+	int heads() const;    // Число ветвей.
 	bool inner(int head, int depth) const;
 	int length(int head) const;
 	BoardState at(int head, int depth) const;
-	void fork(int head, int depth);
-	BoardState cut(int head, int depth);
-	BoardState evolve(int head, std::vector<Cell> action);
+	int fork(int head, int depth);    // Номер ветви, которая кончается этой позицией.
+	int cut(int head, int depth);     // Номер оставшейся ветви.
+	BoardState evolve(int head, std::vector<Cell> action);    // Номер ветви не меняется.
+	int branch(int head, std::vector<Cell> action);    // Новая ветвь из последней позиции head.
+	History history(int head) const;    // Все позиции ветви от начальной.
+	std::vector<std::vector<Cell>> actions(int head) const;    // Ходы ветви от начальной позиции.
+	bool drawn(int head) const;         // Последняя позиция ветви — ничья.
+	Clock& clock(int head, Role color);    // Новая ветвь получает часы от начала контроля.
+	void setClocks(const Clock &control);  // Начать часы всех ветвей заново.
+	void pauseClocks();
+private:
+	// Ход, записанный полями начала, поворотов и конца.
+	struct Move {
+		Move();
+		Move(const std::vector<Cell> &action);
+		std::vector<Cell> action() const;    // Полный ход по одному полю.
+		std::uint8_t points[15];
+		std::uint8_t count;
+	};
+	struct Node {
+		Move move;    // Ход, которым получена позиция; у начальной пуст.
+		int frame;    // Номер позиции в _frames или -1, если она не сохранена.
+	};
+	using Tree = Root<Node>;
 private:
-	Root<BoardState>::Iterator find(int head, int depth) const;
-	bool doesReach(Root<BoardState>::Iterator from, Root<BoardState>::Iterator to) const;
+	Node makeNode(Tree::Iterator from, const BoardState &board, const std::vector<Cell> &action);
+	Tree::Iterator find(int head, int depth) const;
+	bool doesReach(Tree::Iterator from, Tree::Iterator to) const;
+	BoardState rebuild(Tree::Iterator at) const;
+	bool cached(Tree::Iterator at, BoardState &board) const;
+	void remember(Tree::Iterator at, const BoardState &board) const;
+	const History& track(Tree::Iterator head) const;
+	void extend(Tree::Iterator from, Tree::Iterator to, const BoardState &board, bool keep);
 private:
-	Root<BoardState> _game;
+	struct Clocks {
+		Tree::Iterator head;
+		Clock sides[2];
+	};
+	Tree _game;
+	std::vector<BoardState> _frames;    // Позиции, сохранённые целиком.
+	mutable QList<QPair<Tree::Iterator, BoardState>> _cache;    // Недавние, последняя первой.
+	mutable QList<QPair<Tree::Iterator, History>> _histories;    // Истории ветвей по их последним вершинам.
+	QList<Clocks> _clocks;
+	Clock _control;
 };
 
 #endif
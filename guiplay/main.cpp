@@ -1,10 +1,52 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include "main_window.h"
 #include "board_controller.h"
+#include "engine_process.h"
+#include "../board/clock.h"
+#include "../board/minimax.h"
+#include "../board/network.h"
 
 int main(int argc, char **argv) {
 	QApplication app(argc, argv);
+	QCommandLineParser parser;
+	QCommandLineOption network("network", "Файл весов нейронной сети для оценки позиций.", "file");
+	QCommandLineOption weights("weights", "Файл весов оценочной функции.", "file");
+	QCommandLineOption engine("engine", "Искать ходы в отдельном процессе shashki-engine.", "program");
+	QCommandLineOption clock("clock", "Контроль времени: 300, 300+2 или 40/600 (секунды).", "control");
+	parser.addHelpOption();
+	parser.addOption(network);
+	parser.addOption(weights);
+	parser.addOption(engine);
+	parser.addOption(clock);
+	parser.process(app);
+	if (parser.isSet(network)) {
+		std::shared_ptr<const Network> loaded = Network::load(parser.value(network).toStdString());
+		if (!loaded)
+			qFatal("Cannot load the network from %s", qPrintable(parser.value(network)));
+		useNetwork(loaded);
+	}
+	if (parser.isSet(weights)) {
+		Weights loaded;
+		if (!loaded.load(parser.value(weights).toStdString()))
+			qFatal("Cannot load the weights from %s", qPrintable(parser.value(weights)));
+		useWeights(loaded);
+	}
 	MainWindow w;
+	if (parser.isSet(engine)) {    // Файлы весов передаются и внешнему процессу.
+		QStringList arguments;
+		if (parser.isSet(network))
+			arguments << "--network" << parser.value(network);
+		if (parser.isSet(weights))
+			arguments << "--weights" << parser.value(weights);
+		w.useEngine(new EngineProcess(parser.value(engine), arguments));
+	}
+	if (parser.isSet(clock)) {
+		Clock control;
+		if (!Clock::parse(parser.value(clock).toStdString(), control))
+			qFatal("Bad time control %s", qPrintable(parser.value(clock)));
+		w.useClock(control);
+	}
 	w.show();
 	return app.exec();
 }
@@ -1,6 +1,7 @@
 #include "main_window.h"
 #include "board_widget.h"
 #include "board_controller.h"
+#include "engine_process.h"
 #include <QAction>
 #include <QIcon>
 #include <QLabel>
@@ -10,16 +11,19 @@
 #include <QApplication>
 #include <QSettings>
 #include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
 #include "../board/minimax.h"
 
-MainWindow::MainWindow() {
+MainWindow::MainWindow() : _engine(nullptr), _pondering(false), _ponder(false), _ponderStop(false) {
 	_central = new BoardWidget;
 	_control = new BoardController(this);
 	setCentralWidget(_central);
 	auto f = [this](std::vector<Cell> v){receiveAction(v, ActionType::Gui);};
 	connect(_control, &BoardController::moved, this, f);
-	auto finished = &QFutureWatcher<std::vector<Cell>>::finished;
+	auto finished = &QFutureWatcher<Variation>::finished;
 	connect(&_watcher, finished, this, &MainWindow::automaticDone);
+	connect(&_frame, &QTimer::timeout, this, &MainWindow::showFrame);
+	connect(&_tick, &QTimer::timeout, this, &MainWindow::showClocks);
 
 	_fork = new QAction(QIcon(":/make.png"), "Переходить", this);
 	_white = new QAction(QIcon(":/board.png"), "Белые — автоматически", this);
@@ -27,6 +31,9 @@ MainWindow::MainWindow() {
 	_white->setCheckable(true);
 	_black->setCheckable(true);
 	_heads = new QSpinBox;
+	_autoplay = new QAction(QIcon(":/board.png"), "Автоигра", this);
+	_autoplay->setCheckable(true);
+	_games = new QSpinBox;
 	_flip = new QAction(QIcon(":/flip.png"), "Перевернуть доску", this);
 	_cut = new QAction(QIcon(":/cut.png"), "Обрезать игру", this);
 	_first = new QAction("<<", this);
@@ -35,17 +42,24 @@ MainWindow::MainWindow() {
 	_next = new QAction(">", this);
 	_last = new QAction(">>", this);
 	_count = new QLabel;
+	_time = new QLabel;
 	_quit = new QAction(QIcon(":/quit.png"), "Выход", this);
 
 	_heads->setRange(1, 1);
 	_heads->setSuffix(" из 1");
 	_heads->setToolTip("№ игровой ветви");
 	_heads->setFocusPolicy(Qt::NoFocus);
+	_autoplay->setToolTip("Движок играет сам с собой в фоне");
+	_games->setRange(1, 16);
+	_games->setSuffix(" парт.");
+	_games->setToolTip("Число одновременных партий автоигры, каждая в своей ветви");
+	_games->setFocusPolicy(Qt::NoFocus);
 	_prev->setToolTip("Предыдущая позиция");
 	_next->setToolTip("Следующая позиция");
 	_first->setToolTip("Начальная позиция");
 	_last->setToolTip("Последняя позиция");
 	_count->setToolTip("Число шашек");
+	_time->setToolTip("Время на часах белых и чёрных");
 
 	QToolBar *only = addToolBar("tb");
 	only->setObjectName("tb");
@@ -55,6 +69,8 @@ MainWindow::MainWindow() {
 	only->addAction(_white);
 	only->addAction(_black);
 	only->addWidget(_heads);
+	only->addAction(_autoplay);
+	only->addWidget(_games);
 	only->addAction(_flip);
 	only->addAction(_cut);
 	only->addWidget(_score);
@@ -63,6 +79,7 @@ MainWindow::MainWindow() {
 	only->addAction(_next);
 	only->addAction(_last);
 	only->addWidget(_count);
+	only->addWidget(_time);
 	only->addWidget(stretch);
 	only->addAction(_quit);
 
@@ -71,7 +88,8 @@ MainWindow::MainWindow() {
 	connect(_fork, &QAction::triggered, this, &MainWindow::fork);
 	connect(_white, &QAction::triggered, this, &MainWindow::white);
 	connect(_black, &QAction::triggered, this, &MainWindow::black);
-	connect(_heads, vc, this, &MainWindow::updateInputState);
+	connect(_heads, vc, this, &MainWindow::selectHead);
+	connect(_autoplay, &QAction::triggered, this, &MainWindow::autoplay);
 	connect(_flip, &QAction::triggered, this, &MainWindow::flip);
 	connect(_cut, &QAction::triggered, this, &MainWindow::cut);
 	connect(_first, &QAction::triggered, this, &MainWindow::goStart);
@@ -80,6 +98,7 @@ MainWindow::MainWindow() {
 	connect(_last, &QAction::triggered, this, &MainWindow::goFinish);
 	connect(_quit, &QAction::triggered, qApp, &QApplication::quit);
 	connect(qApp, &QApplication::aboutToQuit, this, &MainWindow::saveSettings);
+	connect(qApp, &QApplication::aboutToQuit, this, &MainWindow::stopPondering);
 
 	QApplication::setOrganizationName("Evgeniy");
 	QApplication::setApplicationName("Shashki");
@@ -88,6 +107,7 @@ MainWindow::MainWindow() {
 	restoreSettings();
 
 	_automatic[Role::White] = _automatic[Role::Black] = false;
+	_flagged = Role::None;
 	_depth = _head = 0;
 	requestAction(_game.at(0, 0));
 	updateInputState();
@@ -114,22 +134,38 @@ QString score(Role color, bool lost) {
 }
 
 void MainWindow::updateInputState() {
-	_fork->setEnabled(_depth != 0);
-	_cut->setEnabled(_game.inner(_head, _depth));
+	bool playing = _autoplay->isChecked();
+	_fork->setEnabled(_depth != 0 && !playing);
+	_cut->setEnabled(_game.inner(_head, _depth) && !playing);
+	_white->setEnabled(!playing);
+	_black->setEnabled(!playing);
+	_games->setEnabled(!playing);
 	_first->setEnabled(_game.length(_head) != _depth+1);
 	_prev->setEnabled(_game.length(_head) != _depth+1);
 	_next->setEnabled(_depth != 0);
 	_last->setEnabled(_depth != 0);
 	BoardState board = _game.at(_head, _depth);
-	int white = board.position().stock(Role::White).size();
-	int black = board.position().stock(Role::Black).size();
+	int white = board.position().count(Role::White);
+	int black = board.position().count(Role::Black);
 	_count->setText(QString("%1:%2").arg(white).arg(black));
-	_score->setText(score(board.color(), board.lost()));
-	bool active = (_depth == 0 && !board.lost());
+	bool drawn = _depth == 0 && _game.drawn(_head);
+	_score->setText(drawn ? QString("Ничья") : score(board.color(), board.lost()));
+	bool active = (_depth == 0 && !board.lost() && !drawn && _flagged == Role::None);
 	if (active && !_buffer.empty()) {    // получен ход
-		board = _game.evolve(_head, _buffer);
-		requestAction(board);
+		Role color = board.color();
+		if (_game.clock(_head, color).stop()) {
+			board = _game.evolve(_head, _buffer);
+			requestAction(board);
+		}
+		else {
+			_flagged = color;
+			_buffer.clear();
+			active = false;
+		}
+		showClocks();
 	}
+	if (_flagged != Role::None && _depth == 0)
+		_score->setText(QString("Время %1 вышло").arg(_flagged == Role::White ? "белых" : "чёрных"));
 	_central->setActive(active);
 	_central->setPosition(board.position());
 }
@@ -142,24 +178,238 @@ void MainWindow::receiveAction(std::vector<Cell> action, ActionType type) {
 	updateInputState();
 }
 
+// Ход движка и главное продолжение, из которого берётся ожидаемый ответ.
+Variation think(BoardState board, Limits limits, History history) {
+	Variation best;
+	limits.history = &history;
+	best.action = search(board, limits, [&best](const Progress &progress) {best.line = progress.best.line;});
+	return best;
+}
+
 // подготовка контекста к получению хода для игры
 void MainWindow::requestAction(BoardState board) {
 	_buffer.clear();
-	if (board.lost())
+	bool hit = _pondering && _automatic[board.color()] && board.str() == _pondered.str();
+	if (!hit)
+		stopPondering();
+	History history = _game.history(_head);
+	BoardState start = board;    // для внешнего движка: начало ветви и ходы от него
+	std::vector<std::vector<Cell>> moves;
+	if (history.board().str() != board.str())
+		history = History(board);
+	else if (_engine) {
+		start = _game.at(_head, _game.length(_head)-1);
+		moves = _game.actions(_head);
+	}
+	if (board.lost() || _flagged != Role::None || history.drawn())
 		return;
+	Clock &clock = _game.clock(_head, board.color());
+	if (!clock.running())    // новая позиция; уже идущие часы не перезапускаются
+		clock.start();
 	if (_automatic[board.color()]) {
 		_receiver = ActionType::Automatic;
 		_central->setController(nullptr);
-		_future = QtConcurrent::run(minimax, board);
-		_watcher.setFuture(_future);
+		_asked = board;
+		Limits limits;
+		clock.limit(limits);
+		if (_engine)
+			_engine->request(start, moves, limits);
+		else if (hit) {    // обдумывание продолжается как обычный поиск
+			_pondering = false;
+			_wakeup.set(_ponder, false);
+			_future = _ponderFuture;
+			_watcher.setFuture(_future);
+		}
+		else {
+			_future = QtConcurrent::run(think, board, limits, history);
+			_watcher.setFuture(_future);
+		}
 	}
 	else {
 		_receiver = ActionType::Gui;
 		_central->setController(_control);
+		ponder(history);
+	}
+}
+
+void MainWindow::automaticDone() {
+	Variation found = _future.result();
+	_expected = BoardState();
+	if (found.line.size() > 1 && found.line[0] == found.action) {
+		_expected = _asked;
+		BoardState::apply(_expected, found.action);
+		_reply = found.line[1];
+	}
+	receiveAction(found.action, ActionType::Automatic);
+}
+
+/*
+ * Пока человек думает над ходом, движок обдумывает позицию после
+ * ожидаемого ответа. Если ответ угадан, этот поиск и становится поиском
+ * хода; иначе он прерывается, а найденное остаётся в таблице движка.
+ */
+void MainWindow::ponder(History history) {
+	BoardState board = history.board();
+	Role engine = board.color().opposite();
+	if (!_automatic[engine] || _autoplay->isChecked())
+		return;
+	Limits limits;
+	_game.clock(_head, engine).limit(limits);
+	if (_engine) {
+		_engine->ponder(_game.at(_head, _game.length(_head)-1), _game.actions(_head), limits);
+		return;
+	}
+	if (board.str() != _expected.str())
+		return;
+	_pondered = board;
+	BoardState::apply(_pondered, _reply);
+	history.play(_pondered);
+	_ponder = true;
+	_ponderStop = false;
+	limits.ponder = &_ponder;
+	limits.stop = &_ponderStop;
+	limits.wakeup = &_wakeup;
+	_ponderFuture = QtConcurrent::run(think, _pondered, limits, history);
+	_pondering = true;
+}
+
+void MainWindow::stopPondering() {
+	if (!_pondering)
+		return;
+	_wakeup.set(_ponderStop, true);
+	_ponderFuture.waitForFinished();
+	_pondering = false;
+}
+
+void MainWindow::useEngine(EngineProcess *engine) {
+	_engine = engine;
+	engine->setParent(this);
+	auto f = [this](std::vector<Cell> v){receiveAction(v, ActionType::Automatic);};
+	connect(engine, &EngineProcess::moved, this, f);
+	connect(engine, &EngineProcess::failed, this, &MainWindow::engineFailed);
+}
+
+// Внешний движок хода не дал: этот ход ищется в самом приложении.
+void MainWindow::engineFailed() {
+	BoardState board = _game.at(_head, 0);
+	if (_receiver != ActionType::Automatic || board.str() != _asked.str())
+		return;
+	Limits limits;
+	_game.clock(_head, board.color()).limit(limits);
+	_future = QtConcurrent::run(think, board, limits, _game.history(_head));
+	_watcher.setFuture(_future);
+}
+
+void MainWindow::useClock(const Clock &clock) {
+	_timeControl = clock;
+	_game.setClocks(clock);
+	_flagged = Role::None;
+	requestAction(_game.at(_head, 0));
+	_tick.start(100);
+	showClocks();
+}
+
+void MainWindow::showClocks() {
+	if (!_timeControl.enabled() || _autoplay->isChecked())
+		return;
+	auto show = [](double seconds) {
+		int tenths = qMax(0, qRound(seconds * 10.0));
+		return QString("%1:%2.%3").arg(tenths / 600).arg(tenths / 10 % 60, 2, 10, QChar('0')).arg(tenths % 10);
+	};
+	_time->setText(show(_game.clock(_head, Role::White).remaining()) + " "
+	               + show(_game.clock(_head, Role::Black).remaining()));
+	for (int color = Role::White; color <= Role::Black; ++ color)
+		if (_flagged == Role::None && _game.clock(_head, color).flagged()) {    // ход так и не сделан
+			_flagged = color;
+			_receiver = ActionType::None;
+			_central->setController(nullptr);
+			updateInputState();
+		}
+}
+
+// У каждой ветви свои часы; пока ветвь не выбрана, её время не идёт.
+void MainWindow::selectHead(int number) {
+	_game.pauseClocks();
+	_head = std::max(0, std::min(number-1, _game.heads()-1));
+	_depth = 0;
+	_flagged = Role::None;
+	for (int color = Role::White; color <= Role::Black; ++ color)
+		if (_game.clock(_head, color).flagged())
+			_flagged = color;
+	showHeads();
+	if (!_autoplay->isChecked())
+		requestAction(_game.at(_head, _depth));
+	updateInputState();
+}
+
+// Переключатель ветвей показывает их число и текущую; сигнал при этом не посылается.
+void MainWindow::showHeads() {
+	_heads->blockSignals(true);
+	_heads->setRange(1, _game.heads());
+	_heads->setSuffix(QString(" из %1").arg(_game.heads()));
+	_heads->setValue(_head+1);
+	_heads->blockSignals(false);
+}
+
+/*
+ * Автоигра: каждая из _games партий получает свою ветвь от текущей
+ * позиции и начинается своим ходом (i-м по порядку distinct), дальше
+ * ходы выбирает движок в фоновых потоках. Ходы переносятся в дерево
+ * игры не чаще FrameRate раз в секунду.
+ */
+void MainWindow::autoplay(bool on) {
+	const int FrameRate = 25;
+	if (!on) {
+		_frame.stop();
+		_player.stop();
+		showFrame();
+		requestAction(_game.at(_head, 0));
+		updateInputState();
+		return;
 	}
+	BoardState board = _game.at(_head, 0);
+	std::vector<std::vector<Cell>> first = distinct(board);
+	if (board.lost() || first.empty()) {
+		_autoplay->setChecked(false);
+		return;
+	}
+	stopPondering();
+	_game.pauseClocks();    // у фоновых партий свои часы
+	_receiver = ActionType::None;
+	_buffer.clear();
+	_central->setController(nullptr);
+	_depth = 0;
+	QList<int> heads;
+	if (_games->value() == 1)
+		heads.append(_head);
+	else {
+		int count = std::min<int>(_games->value(), first.size());
+		for (int i = 1; i < count; ++ i)
+			heads.append(_game.branch(_head, first[i]));
+		_game.evolve(_head, first[0]);
+		heads.prepend(_head);
+		showHeads();
+	}
+	QList<QPair<int, History>> games;
+	for (int head : heads)
+		games.append(qMakePair(head, _game.history(head)));
+	_player.start(games, _timeControl);
+	_frame.start(1000 / FrameRate);
+	updateInputState();
 }
 
-void MainWindow::automaticDone() {receiveAction(_future.result(), ActionType::Automatic);}
+// Накопленные ходы фоновых партий переносятся в дерево, окно обновляется один раз.
+void MainWindow::showFrame() {
+	QList<QPair<int, std::vector<Cell>>> moves = _player.take();
+	for (auto &move : moves)
+		_game.evolve(move.first, move.second);
+	if (!moves.isEmpty())
+		updateInputState();
+	if (!_player.running() && _autoplay->isChecked()) {
+		_autoplay->setChecked(false);
+		autoplay(false);
+	}
+}
 
 void MainWindow::goBack() {++ _depth; updateInputState();}
 void MainWindow::goForth() {-- _depth; updateInputState();}
@@ -169,14 +419,7 @@ void MainWindow::goFinish() {_depth = 0; updateInputState();}
 void MainWindow::flip() {_central->setFlipped(!_central->flipped());}
 
 void MainWindow::fork() {
-	_game.fork(_head, _depth);
-	_heads->setMaximum(_heads->maximum()+1);
-	_heads->setSuffix(QString(" из %1").arg(_heads->maximum()));
-	_head = _heads->maximum()-1;
-	_depth = 0;
-	_heads->setValue(_heads->maximum()-1);
-	requestAction(_game.at(_head, _depth));
-	updateInputState();
+	selectHead(_game.fork(_head, _depth)+1);
 }
 
 void MainWindow::white(bool on) {
@@ -194,9 +437,7 @@ void MainWindow::black(bool on) {
 }
 
 void MainWindow::cut() {
-	requestAction(_game.cut(_head, _depth));
-	_head = _depth = 0;
-	updateInputState();
+	selectHead(_game.cut(_head, _depth)+1);
 }
 
 void MainWindow::restoreSettings() {
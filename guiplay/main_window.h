@@ -4,11 +4,16 @@
 #include <QMainWindow>
 #include "../board/board_state.h"
 #include "../board/cell.h"
+#include "../board/clock.h"
+#include "../board/minimax.h"
 #include "game.h"
 #include "action_type.h"
+#include "autoplay.h"
 #include <QList>
 #include <QFutureWatcher>
 #include <QFuture>
+#include <QTimer>
+#include <atomic>
 
 class QComboBox;
 class QSpinBox;
@@ -16,6 +21,7 @@ class QAction;
 class QLabel;
 class BoardWidget;
 class BoardController;
+class EngineProcess;
 
 class MainWindow : public QMainWindow {
 	Q_OBJECT
@@ -36,11 +42,23 @@ public:
 	void saveSettings();
 	void restoreSettings();
 	void automaticDone();
+	void ponder(History history);
+	void stopPondering();
+	void useEngine(EngineProcess *engine);    // Искать ходы во внешнем процессе.
+	void engineFailed();
+	void useClock(const Clock &clock);        // Играть на время с этим контролем у обеих сторон.
+	void showClocks();
+	void selectHead(int number);
+	void showHeads();
+	void autoplay(bool on);
+	void showFrame();
 private:
 	QAction *_fork;
 	QAction *_white;
 	QAction *_black;
 	QSpinBox *_heads;
+	QAction *_autoplay;
+	QSpinBox *_games;
 	QAction *_flip;
 	QAction *_cut;
 	QAction *_first;
@@ -49,12 +67,18 @@ private:
 	QAction *_next;
 	QAction *_last;
 	QLabel *_count;
+	QLabel *_time;
 	QAction *_quit;
 private:
 	BoardWidget *_central;
 	BoardController *_control;
-	QFutureWatcher<std::vector<Cell>> _watcher;
-	QFuture<std::vector<Cell>> _future;
+	QFutureWatcher<Variation> _watcher;
+	QFuture<Variation> _future;
+	QFuture<Variation> _ponderFuture;
+	EngineProcess *_engine;
+	Autoplay _player;    // партии движка с самим собой в фоне.
+	QTimer _frame;       // забирает ходы фоновых партий и обновляет окно.
+	QTimer _tick;        // обновляет показания часов.
 private:
 	Game _game;    // дерево игры: позиции после каждого полного полухода.
 	int _head;     // текущая вершина в дереве позиций, то есть текущая игра.
@@ -63,6 +87,15 @@ private:
 	std::vector<Cell> _buffer;   // буфер ходов, полученных со стороны.
 	ActionType _receiver;
 	bool _automatic[2];
+	Clock _timeControl;  // контроль времени, с которого начинаются часы.
+	Role _flagged;       // у этой стороны вышло время.
+	BoardState _asked;       // позиция, для которой движок ищет ход.
+	BoardState _expected;    // позиция после хода движка, где ожидается ответ _reply.
+	std::vector<Cell> _reply;
+	BoardState _pondered;    // позиция после ожидаемого ответа, обдумываемая заранее.
+	bool _pondering;
+	std::atomic<bool> _ponder, _ponderStop;
+	Wakeup _wakeup;
 };
 
 #endif
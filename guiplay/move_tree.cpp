@@ -0,0 +1,135 @@
+#include "move_tree.h"
+#include "../board/minimax.h"
+#include <algorithm>
+
+MoveTree::MoveTree() {
+	append(-1, Cell(), false);
+}
+
+MoveTree::MoveTree(const BoardState &board) : MoveTree() {
+	for (const std::vector<Cell> &action : explore(board)) {
+		BoardState copy = board;
+		int node = 0;
+		for (Cell cell : action) {
+			copy.control(cell);
+			int next = cell.valid() ? _nodes[node].child : _nodes[node].end;
+			while (next >= 0 && _nodes[next].cell != cell)
+				next = _nodes[next].sibling;
+			if (next < 0)
+				next = append(node, cell, copy.capture());
+			node = next;
+		}
+		std::uint32_t below = 0;
+		for (; node > 0; node = _nodes[node].parent) {
+			_nodes[node].below |= below;
+			if (_nodes[node].cell.valid())
+				below |= 1u << _nodes[node].cell.index();
+		}
+	}
+}
+
+int MoveTree::append(int parent, Cell cell, bool capture) {
+	Node node;
+	node.cell = cell;
+	node.capture = capture;
+	node.parent = parent;
+	node.child = node.sibling = node.end = -1;
+	node.depth = parent > 0 ? _nodes[parent].depth + 1 : 0;
+	node.captures = (parent > 0 ? _nodes[parent].captures : 0) + capture;
+	node.below = 0;
+	int index = _nodes.size();
+	if (parent >= 0) {
+		if (!cell.valid())
+			_nodes[parent].end = index;
+		else {
+			node.sibling = _nodes[parent].child;
+			_nodes[parent].child = index;
+		}
+	}
+	_nodes.push_back(node);
+	return index;
+}
+
+int MoveTree::start(Cell at) const {
+	for (int node = _nodes[0].child; node >= 0; node = _nodes[node].sibling)
+		if (_nodes[node].cell == at)
+			return node;
+	return -1;
+}
+
+// Поиск вершин, через которые ход проходит по полю at дальше count-го поля,
+// и завершений хода на at сразу после выбранного. first — взятия до первого
+// прохода через at на пути к вершине, -1, если прохода не было.
+void MoveTree::collect(int node, int count, Cell at, int first, std::vector<Candidate> &found) const {
+	const Node &n = _nodes[node];
+	if (n.cell == at && first < 0)
+		first = n.captures - n.capture;
+	if (n.cell == at && n.depth >= count) {
+		found.push_back(Candidate{node, first});
+		return;
+	}
+	if (n.cell == at && n.depth == count-1 && n.end >= 0)
+		found.push_back(Candidate{n.end, first});
+	if (!(n.below & (1u << at.index())))
+		return;
+	for (int child = n.child; child >= 0; child = _nodes[child].sibling)
+		collect(child, count, at, first, found);
+}
+
+int MoveTree::meet(int a, int b) const {
+	while (_nodes[a].depth > _nodes[b].depth)
+		a = _nodes[a].parent;
+	while (_nodes[b].depth > _nodes[a].depth)
+		b = _nodes[b].parent;
+	while (a != b) {
+		a = _nodes[a].parent;
+		b = _nodes[b].parent;
+	}
+	return a;
+}
+
+QList<Cell> MoveTree::path(int node) const {
+	QList<Cell> result;
+	for (; node > 0; node = _nodes[node].parent) {
+		Cell cell = _nodes[node].cell;
+		cell.setCapture(_nodes[node].capture);
+		result.prepend(cell);
+	}
+	return result;
+}
+
+QList<Cell> MoveTree::choose(int start, int count, Cell at) const {
+	if (start <= 0 || !at.valid())
+		return QList<Cell>();
+	std::vector<Candidate> found;
+	collect(start, count, at, -1, found);
+	if (found.empty())
+		return QList<Cell>();
+	int least = found.front().captures;
+	for (const Candidate &c : found)
+		least = std::min(least, c.captures);
+	int common = -1, chosen = 0;
+	for (const Candidate &c : found)
+		if (c.captures == least) {
+			common = common < 0 ? c.node : meet(common, c.node);
+			++ chosen;
+		}
+	// Единственная выбранная вершина: выбраны все ходы ниже неё,
+	// и общая часть тянется, пока продолжение однозначно.
+	bool whole = chosen == 1 && _nodes[common].cell.valid();
+	if (whole)
+		while (_nodes[common].cell.valid()) {
+			const Node &n = _nodes[common];
+			int child = n.child;
+			if ((n.end >= 0) + (child >= 0) != 1 || (child >= 0 && _nodes[child].sibling >= 0))
+				break;
+			common = n.end >= 0 ? n.end : child;
+		}
+	const Node &n = _nodes[common];
+	bool ending = whole;
+	for (const Candidate &c : found)
+		ending = ending || (c.captures == least && c.node == n.end);
+	if (n.cell.valid() && n.cell == at && n.end >= 0 && ending)
+		common = n.end;
+	return path(common);
+}
@@ -0,0 +1,53 @@
+#ifndef MOVE_TREE_H
+#define MOVE_TREE_H
+
+#include <QList>
+#include <cstdint>
+#include <vector>
+#include "../board/board_state.h"
+#include "../board/cell.h"
+
+/*
+ * Все полные ходы позиции, собранные в префиксное дерево по полям.
+ * Строится один раз на позицию из списка explore(). Вершина на глубине i
+ * соответствует i-му полю хода (начальное поле на глубине 0), а лист —
+ * завершению хода. Для каждой вершины хранятся поля, которые встречаются
+ * ниже неё, и число взятий на пути к ней, так что выбор хода по полю,
+ * на которое нажали, не требует повторять ходы на доске.
+ */
+
+class MoveTree {
+public:
+	MoveTree();
+	explicit MoveTree(const BoardState &board);
+	int start(Cell at) const;     // Вершина начального поля at или -1.
+	// Выбор по полю at, когда первые count полей хода уже выбраны, начиная со start:
+	// общая часть всех ходов, проходящих через at дальше выбранного за наименьшее
+	// число взятий. Если на at можно и нужно закончить ход, в конце стоит пустое поле.
+	// Пустой список, если таких ходов нет.
+	QList<Cell> choose(int start, int count, Cell at) const;
+private:
+	struct Node {
+		Cell cell;               // Пустое поле у завершения хода.
+		bool capture;            // Шашка, встав на это поле, бьёт.
+		int parent;
+		int child;               // Первый потомок или -1.
+		int sibling;             // Следующий потомок того же родителя или -1.
+		int end;                 // Потомок-завершение или -1.
+		int depth;
+		int captures;            // Взятия на пути к вершине, включая её.
+		std::uint32_t below;     // Поля всех потомков.
+	};
+	struct Candidate {
+		int node;
+		int captures;    // Взятия до первого прохода через поле.
+	};
+	int append(int parent, Cell cell, bool capture);
+	void collect(int node, int count, Cell at, int first, std::vector<Candidate> &found) const;
+	int meet(int a, int b) const;
+	QList<Cell> path(int node) const;
+private:
+	std::vector<Node> _nodes;    // Нулевая вершина — общий корень над начальными полями.
+};
+
+#endif
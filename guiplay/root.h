@@ -2,6 +2,7 @@
 #define ROOT_H
 
 #include <QList>
+#include <QVector>
 
 template<typename T>
 class Root {
@@ -21,18 +22,32 @@ public:
 	Root(T data);
 	QList<Iterator> heads() const;
 	Iterator prev(Iterator at) const;
+	int depth(Iterator at) const;    // Число шагов до источника.
+	Iterator ancestorAt(Iterator at, int depth) const;    // Предок на заданной глубине.
+	bool isAncestor(Iterator ancestor, Iterator at) const;    // Истина и при совпадении.
 	void markHead(Iterator at);
 	void unmarkHead(Iterator head);
 	Iterator appendHead(Iterator at, T data);
+	Iterator extendHead(Iterator head, T data);    // Продолжение заменяет голову под её номером.
 	QList<T> makeList(Iterator head) const;
 	const T& operator [](Iterator at) const;
 private:
+	Iterator append(Iterator at, T data);
+private:
+	/*
+	 * Кроме родителя, у каждой вершины есть ссылка на дальнего предка,
+	 * выбранного по косой двоичной системе счисления: от любой вершины
+	 * до предка на любой глубине — O(log n) переходов по этим ссылкам.
+	 */
 	struct Data {
-		Data (Iterator p, T d) : parent(p), data(d) {}
+		Data () : depth(0) {}
+		Data (Iterator p, Iterator j, int n, T d) : parent(p), jump(j), depth(n), data(d) {}
 		Iterator parent;
+		Iterator jump;
+		int depth;
 		T data;
 	};
-	QList<Data> _contents;
+	QVector<Data> _contents;
 	QList<Iterator> _heads;
 };
 
@@ -1,7 +1,7 @@
 #include "root.h"
 
 template<typename T> Root<T>::Root(T data) {
-	_contents.append(Data(-1, data));
+	_contents.append(Data(-1, 0, 0, data));
 	_heads.append(0);
 }
 
@@ -13,6 +13,22 @@ template<typename T> typename Root<T>::Iterator Root<T>::prev(Iterator at) const
 	return _contents[at._value].parent;
 }
 
+template<typename T> int Root<T>::depth(Iterator at) const {
+	return _contents[at._value].depth;
+}
+
+template<typename T> typename Root<T>::Iterator Root<T>::ancestorAt(Iterator at, int depth) const {
+	while (this->depth(at) > depth) {
+		const Data &node = _contents[at._value];
+		at = this->depth(node.jump) >= depth ? node.jump : node.parent;
+	}
+	return at;
+}
+
+template<typename T> bool Root<T>::isAncestor(Iterator ancestor, Iterator at) const {
+	return depth(ancestor) <= depth(at) && ancestorAt(at, depth(ancestor)) == ancestor;
+}
+
 template<typename T> void Root<T>::markHead(Iterator at) {
 	if (!_heads.contains(at))
 		_heads.append(at);
@@ -23,22 +39,35 @@ template<typename T> void Root<T>::unmarkHead(Iterator head) {
 }
 
 template<typename T> typename Root<T>::Iterator Root<T>::appendHead(Iterator at, T data) {
-	_heads.append(_contents.size());
-	_contents.append(Data(at, data));
+	_heads.append(append(at, data));
 	return _heads.last();
 }
 
+template<typename T> typename Root<T>::Iterator Root<T>::extendHead(Iterator head, T data) {
+	Iterator next = append(head, data);
+	_heads[_heads.indexOf(head)] = next;
+	return next;
+}
+
+template<typename T> typename Root<T>::Iterator Root<T>::append(Iterator at, T data) {
+	Iterator jump = _contents[at._value].jump;
+	Iterator further = _contents[jump._value].jump;
+	if (depth(at) - depth(jump) != depth(jump) - depth(further))
+		further = at;
+	_contents.append(Data(at, further, depth(at)+1, data));
+	return _contents.size()-1;
+}
+
 template<typename T> const T& Root<T>::operator [](Iterator at) const {
 	return _contents[at._value].data;
 }
 
 template<typename T> QList<T> Root<T>::makeList(Iterator head) const {
-   QList<T> list;
-   typename Root<T>::Iterator it = head;
-   while (true) {
-	   list.prepend((*this)[it]);
-	   if (it.source())
-		   return list;
-	   it = prev(it);
-   }
+	QVector<T> path(depth(head)+1);
+	typename Root<T>::Iterator it = head;
+	for (int i = path.size()-1; i >= 0; -- i) {
+		path[i] = (*this)[it];
+		it = prev(it);
+	}
+	return path.toList();
 }
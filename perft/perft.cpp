@@ -0,0 +1,302 @@
+#include "../board/board_state.h"
+#include "../board/minimax.h"
+#include "../board/history.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Счёт позиций (perft): число последовательностей полных ходов заданной
+ * длины от каждой заданной позиции, для глубин от 1 до заданной. Ходы
+ * строит автомат BoardState, поэтому глубокие счёты, сверенные с чужими,
+ * проверяют правила (и BoardState::browse) там, куда случайные партии
+ * не доходят. Поддеревья второго полухода раздаются потокам; счёты уже
+ * посчитанных поддеревьев запоминаются в общей таблице по ключу позиции
+ * и глубине. С ключом --distinct ходы, ведущие к одной позиции, считаются
+ * одним (как их видит поиск), с ключом --divide счёт делится по ходам корня.
+ * С ключом --expect счёт на последней глубине сверяется с заданным, и при
+ * расхождении программа завершается с ненулевым кодом.
+ */
+
+namespace {
+
+/*
+ * Таблица счётов без блокировок: в первом слове ключ, сложенный по модулю 2
+ * со счётом, поэтому наполовину переписанная другим потоком запись
+ * не совпадёт ни с каким ключом.
+ */
+class Table {
+public:
+	Table(std::size_t megabytes) : _size(0) {
+		std::size_t count = megabytes * 1024 * 1024 / sizeof(Entry);
+		if (!count)
+			return;
+		_size = 1;
+		while (_size * 2 <= count)
+			_size *= 2;
+		_entries.reset(new Entry[_size]);
+		for (std::size_t i = 0; i < _size; ++ i) {
+			_entries[i].check.store(0, std::memory_order_relaxed);
+			_entries[i].count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	bool probe(std::uint64_t key, int depth, std::uint64_t &count) const {
+		if (!_size)
+			return false;
+		std::uint64_t mark = combine(key, depth);
+		const Entry &entry = _entries[mark & (_size-1)];
+		std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+		count = entry.count.load(std::memory_order_relaxed);
+		return count && (check ^ count) == mark;
+	}
+
+	void store(std::uint64_t key, int depth, std::uint64_t count) {
+		if (!_size)
+			return;
+		std::uint64_t mark = combine(key, depth);
+		Entry &entry = _entries[mark & (_size-1)];
+		entry.check.store(mark ^ count, std::memory_order_relaxed);
+		entry.count.store(count, std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry {
+		std::atomic<std::uint64_t> check;
+		std::atomic<std::uint64_t> count;
+	};
+	static std::uint64_t combine(std::uint64_t key, int depth) {
+		return key ^ (static_cast<std::uint64_t>(depth) * 0x9E3779B97F4A7C15ull);
+	}
+	std::unique_ptr<Entry[]> _entries;
+	std::size_t _size;
+};
+
+// Позиции после всех продолжений уже начатого хода, прямо по автомату.
+void complete(const BoardState &board, Cell last, std::vector<BoardState> &out) {
+	if (!last.valid()) {
+		out.push_back(board);
+		return;
+	}
+	for (Cell cell : Cell::neighbours(last)) {
+		BoardState copy = board;
+		if (copy.control(cell))
+			complete(copy, cell, out);
+	}
+}
+
+bool same(const Position &p1, const Position &p2) {
+	return p1.mask(Role::White) == p2.mask(Role::White) && p1.mask(Role::Black) == p2.mask(Role::Black)
+	       && p1.kings() == p2.kings();
+}
+
+// Позиции после всех полных ходов; с distinct — без повторов, как у distinct().
+std::vector<BoardState> expand(const BoardState &board, bool distinct) {
+	std::vector<BoardState> out;
+	for (Cell stone : board.position().stock(board.color())) {
+		BoardState copy = board;
+		if (copy.control(stone))
+			complete(copy, stone, out);
+	}
+	if (distinct && !board.quiet()) {
+		auto end = out.begin();
+		for (auto i = out.begin(); i != out.end(); ++ i)
+			if (std::find_if(out.begin(), end, [&](const BoardState &b) {return same(b.position(), i->position());}) == end)
+				*end++ = *i;
+		out.erase(end, out.end());
+	}
+	return out;
+}
+
+// Счёт в одном потоке; nodes — сколько позиций раскрыто.
+class Counter {
+public:
+	Counter(Table &table, bool distinct) : nodes(0), hits(0), _table(table), _distinct(distinct) {}
+
+	std::uint64_t count(const BoardState &board, int depth) {
+		if (depth == 0)
+			return 1;
+		std::uint64_t key = 0, result = 0;
+		if (depth > 1) {
+			key = History::key(board);
+			std::uint64_t stored;
+			if (_table.probe(key, depth, stored)) {
+				++ hits;
+				return stored;
+			}
+		}
+		++ nodes;
+		std::vector<BoardState> next = expand(board, _distinct);
+		if (depth == 1)
+			return next.size();
+		for (const BoardState &child : next)
+			result += count(child, depth-1);
+		_table.store(key, depth, result);
+		return result;
+	}
+
+public:
+	unsigned long long nodes;
+	unsigned long long hits;
+
+private:
+	Table &_table;
+	bool _distinct;
+};
+
+// Поддерево, которое считает один поток: позиция после хода root (и, может быть, ответа на него).
+struct Task {
+	std::size_t root;
+	BoardState board;
+	int depth;
+	std::uint64_t count;
+};
+
+struct Options {
+	int depth = 8;
+	unsigned int threads = 0;
+	std::size_t hash = 64;      // Мегабайт на таблицу; 0 — без таблицы.
+	bool distinct = false;
+	bool divide = false;
+	long long expect = -1;      // Ожидаемый счёт на последней глубине; -1 — не сверять.
+	std::vector<std::string> roots;
+};
+
+struct Run {
+	std::uint64_t total;
+	std::vector<std::uint64_t> divided;    // По ходам корня.
+	std::vector<unsigned long long> nodes, hits;    // По потокам.
+	double seconds;
+};
+
+Run perft(const BoardState &root, const std::vector<std::vector<Cell>> &actions, int depth,
+          const Options &options, Table &table) {
+	Run run;
+	run.divided.assign(actions.size(), 0);
+	std::vector<Task> tasks;
+	for (std::size_t i = 0; i < actions.size(); ++ i) {
+		BoardState board = root;
+		BoardState::apply(board, actions[i]);
+		if (depth <= 2)
+			tasks.push_back({i, board, depth-1, 0});
+		else
+			for (const BoardState &reply : expand(board, options.distinct))
+				tasks.push_back({i, reply, depth-2, 0});
+	}
+	std::atomic<std::size_t> next(0);
+	std::vector<std::unique_ptr<Counter>> counters;
+	for (unsigned int i = 0; i < options.threads; ++ i)
+		counters.emplace_back(new Counter(table, options.distinct));
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (unsigned int i = 0; i < options.threads; ++ i)
+		pool.emplace_back([&, i] {
+			for (std::size_t t = next++; t < tasks.size(); t = next++)
+				tasks[t].count = counters[i]->count(tasks[t].board, tasks[t].depth);
+		});
+	for (std::thread &thread : pool)
+		thread.join();
+	run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	run.total = 0;
+	for (const Task &task : tasks) {
+		run.divided[task.root] += task.count;
+		run.total += task.count;
+	}
+	for (const auto &counter : counters) {
+		run.nodes.push_back(counter->nodes);
+		run.hits.push_back(counter->hits);
+	}
+	return run;
+}
+
+// Миллионы в секунду.
+double rate(unsigned long long count, double seconds) {
+	return seconds > 0.0 ? count / seconds / 1e6 : 0.0;
+}
+
+const char *DefaultRoots[] = {
+	"W:WA1,C1,E1,G1,B2,D2,F2,H2,A3,C3,E3,G3:BB6,D6,F6,H6,A7,C7,E7,G7,B8,D8,F8,H8",
+};
+
+void usage() {
+	std::cerr << "Usage: board_perft [--depth N] [--threads N] [--hash MB] [--distinct] [--divide]"
+	             " [--expect COUNT] [--position NOTATION]...\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+	Options options;
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		bool more = i+1 < argc;
+		if (arg == "--depth" && more)
+			options.depth = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--threads" && more)
+			options.threads = std::strtoul(argv[++ i], nullptr, 10);
+		else if (arg == "--hash" && more)
+			options.hash = std::strtoul(argv[++ i], nullptr, 10);
+		else if (arg == "--distinct")
+			options.distinct = true;
+		else if (arg == "--divide")
+			options.divide = true;
+		else if (arg == "--expect" && more)
+			options.expect = std::atoll(argv[++ i]);
+		else if (arg == "--position" && more)
+			options.roots.push_back(argv[++ i]);
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (options.roots.empty())
+		options.roots.assign(std::begin(DefaultRoots), std::end(DefaultRoots));
+	if (!options.threads)
+		options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+	Table table(options.hash);
+	for (const std::string &notation : options.roots) {
+		BoardState root = BoardState::fromString(notation);
+		if (!root.color().valid()) {
+			std::cerr << "Bad position: " << notation << '\n';
+			return 1;
+		}
+		std::vector<std::vector<Cell>> actions = options.distinct ? distinct(root) : explore(root);
+		std::cout << root.str() << '\n';
+		for (int depth = 1; depth <= options.depth; ++ depth) {
+			Run run = perft(root, actions, depth, options, table);
+			unsigned long long nodes = 0, hits = 0;
+			for (std::size_t i = 0; i < run.nodes.size(); ++ i) {
+				nodes += run.nodes[i];
+				hits += run.hits[i];
+			}
+			std::cout << std::fixed << std::setprecision(3) << "perft " << depth << ": " << run.total
+			          << "  (" << run.seconds << " s, " << nodes << " nodes, " << hits << " table hits, "
+			          << rate(nodes, run.seconds) << " Mnodes/s)\n";
+			if (depth < options.depth)
+				continue;
+			if (options.expect >= 0 && run.total != static_cast<std::uint64_t>(options.expect)) {
+				std::cerr << "perft " << depth << " of " << notation << ": " << run.total
+				          << ", expected " << options.expect << '\n';
+				return 1;
+			}
+			if (options.threads > 1)
+				for (std::size_t i = 0; i < run.nodes.size(); ++ i)
+					std::cout << "  thread " << i << ": " << run.nodes[i] << " nodes, "
+					          << rate(run.nodes[i], run.seconds) << " Mnodes/s\n";
+			if (options.divide)
+				for (std::size_t i = 0; i < actions.size(); ++ i)
+					std::cout << "  " << root.notation(actions[i]) << ": " << run.divided[i] << '\n';
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,300 @@
+#include "../board/board_state.h"
+#include "../board/minimax.h"
+#include "../board/weights.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Подбор весов оценочной функции по партиям (метод Тексела).
+ *
+ * Каждый образец — позиция и исход партии, из которой она взята, с точки
+ * зрения белых: 1, 1/2 или 0. Оценка позиции переводится в ожидаемый исход
+ * как 1/(1+exp(-K·ln(оценка))); подбираются веса, при которых средний квадрат
+ * отклонения ожидаемого исхода от действительного наименьший. Сначала по
+ * исходным весам подбирается K, затем веса меняются покоординатным поиском
+ * с уменьшающимся шагом. Шаг, после которого какая-либо позиция могла бы
+ * получить оценку не строже BlackWin и WhiteWin, не делается. Ошибка
+ * считается параллельно по частям выборки.
+ * После каждого удачного прохода веса записываются в выходной файл, который
+ * принимают cliplay и guiplay (ключ --weights) и который можно указать
+ * при следующем запуске, чтобы продолжить подбор.
+ */
+
+namespace {
+
+struct Sample {
+	Material white, black;
+	bool final;           // Игрок, который должен ходить, уже проиграл.
+	double finalScore;
+	double result;
+};
+
+bool parseResult(std::string word, double &result) {
+	if (word == "1-0" || word == "1")
+		result = 1.0;
+	else if (word == "0-1" || word == "0")
+		result = 0.0;
+	else if (word == "1/2-1/2" || word == "1/2" || word == "0.5")
+		result = 0.5;
+	else
+		return false;
+	return true;
+}
+
+bool loadSamples(const std::string &path, std::vector<Sample> &samples) {
+	std::ifstream file(path);
+	if (!file)
+		return false;
+	std::string line;
+	int number = 0;
+	while (std::getline(file, line)) {
+		++ number;
+		std::istringstream in(line);
+		std::string notation, word;
+		if (!(in >> notation) || notation[0] == '#')
+			continue;
+		Sample sample;
+		BoardState board = BoardState::fromString(notation);
+		if (!board.color().valid() || !(in >> word) || !parseResult(word, sample.result)) {
+			std::cerr << path << ":" << number << ": bad sample\n";
+			return false;
+		}
+		sample.white = Material(board.position(), Role::White);
+		sample.black = Material(board.position(), Role::Black);
+		sample.final = board.lost();
+		sample.finalScore = board.color() == Role::White ? BlackWin : WhiteWin;
+		samples.push_back(sample);
+	}
+	return true;
+}
+
+// Средний квадрат ошибки, вычисляемый постоянным набором потоков по частям выборки.
+class Shards {
+public:
+	Shards(const std::vector<Sample> &samples, unsigned int threads)
+		: _samples(samples), _generation(0), _pending(0), _quit(false), _sums(threads) {
+		for (unsigned int i = 0; i < threads; ++ i)
+			_threads.emplace_back(&Shards::work, this, i);
+	}
+
+	~Shards() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_quit = true;
+		}
+		_start.notify_all();
+		for (std::thread &thread : _threads)
+			thread.join();
+	}
+
+	double error(const Weights &weights, double k) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_weights = weights;
+		_k = k;
+		_pending = _threads.size();
+		++ _generation;
+		_start.notify_all();
+		_done.wait(lock, [this] {return _pending == 0;});
+		double sum = 0.0;
+		for (double part : _sums)
+			sum += part;
+		return sum / _samples.size();
+	}
+
+private:
+	void work(unsigned int index) {
+		unsigned long seen = 0;
+		while (true) {
+			Weights weights;
+			double k;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_start.wait(lock, [&] {return _quit || _generation != seen;});
+				if (_quit)
+					return;
+				seen = _generation;
+				weights = _weights;
+				k = _k;
+			}
+			std::size_t size = _samples.size(), count = _threads.size();
+			std::size_t begin = size * index / count, end = size * (index+1) / count;
+			double sum = 0.0;
+			for (std::size_t i = begin; i < end; ++ i) {
+				const Sample &s = _samples[i];
+				double score = s.finalScore;
+				if (!s.final) {
+					double wc = weights.strength(s.white), bc = weights.strength(s.black);
+					score = (wc > 0.0 && bc > 0.0) ? wc/bc : std::numeric_limits<double>::quiet_NaN();
+				}
+				double expected = 1.0 / (1.0 + std::exp(-k * std::log(score)));
+				sum += (s.result - expected) * (s.result - expected);
+			}
+			std::lock_guard<std::mutex> lock(_mutex);
+			_sums[index] = sum;
+			if (-- _pending == 0)
+				_done.notify_one();
+		}
+	}
+
+private:
+	const std::vector<Sample> &_samples;
+	std::vector<std::thread> _threads;
+	std::mutex _mutex;
+	std::condition_variable _start, _done;
+	unsigned long _generation;
+	std::size_t _pending;
+	bool _quit;
+	Weights _weights;
+	double _k;
+	std::vector<double> _sums;
+};
+
+// Веса не бывают отрицательными, и никакая сторона (не больше 12 шашек) не сильнее
+// другой (хотя бы одна шашка) в WhiteWin раз, так что оценка лежит строго внутри
+// выигрышей и проигрышей.
+bool bounded(const Weights &weights) {
+	if (!(weights.man > 0.0 && weights.king > 0.0 && weights.advance >= 0.0 && weights.centre >= 0.0))
+		return false;
+	double strongest = 12*std::max(weights.man + 6*weights.advance, weights.king) + 8*weights.centre;
+	double weakest = std::min(weights.man, weights.king);
+	return strongest < weakest * WhiteWin;
+}
+
+// Подобрать K по исходным весам: поиск золотым сечением на [0.01, 10].
+double fitScale(Shards &shards, const Weights &weights) {
+	const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+	double a = 0.01, b = 10.0;
+	double c = b - ratio*(b-a), d = a + ratio*(b-a);
+	double fc = shards.error(weights, c), fd = shards.error(weights, d);
+	while (b - a > 1e-4) {
+		if (fc < fd) {
+			b = d; d = c; fd = fc;
+			c = b - ratio*(b-a);
+			fc = shards.error(weights, c);
+		}
+		else {
+			a = c; c = d; fc = fd;
+			d = a + ratio*(b-a);
+			fd = shards.error(weights, d);
+		}
+	}
+	return (a+b) / 2.0;
+}
+
+void usage() {
+	std::cerr << "Usage: tune SAMPLES [--weights FILE] [--output FILE] [--threads N]"
+	             " [--passes N] [--scale K]\n"
+	             "SAMPLES holds lines '<position> <result>', e.g. 'W:WC3:BF6 1/2-1/2'.\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+	std::string input = argv[1], output = "weights.txt";
+	Weights weights;
+	unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+	int passes = 100;
+	double scale = 0.0;
+	for (int i = 2; i < argc; ++ i) {
+		std::string arg = argv[i];
+		bool more = i+1 < argc;
+		if (arg == "--weights" && more) {
+			if (!weights.load(argv[++ i])) {
+				std::cerr << "Cannot load weights from " << argv[i] << '\n';
+				return 1;
+			}
+		}
+		else if (arg == "--output" && more)
+			output = argv[++ i];
+		else if (arg == "--threads" && more)
+			threads = std::max(1, std::atoi(argv[++ i]));
+		else if (arg == "--passes" && more)
+			passes = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--scale" && more)
+			scale = std::atof(argv[++ i]);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (!bounded(weights)) {
+		std::cerr << "Weights out of range: king " << weights.king << ", advance " << weights.advance
+		          << ", centre " << weights.centre << '\n';
+		return 1;
+	}
+
+	std::vector<Sample> samples;
+	if (!loadSamples(input, samples))
+		return 1;
+	if (samples.empty()) {
+		std::cerr << "No samples in " << input << '\n';
+		return 1;
+	}
+	Shards shards(samples, threads);
+	if (scale <= 0.0)
+		scale = fitScale(shards, weights);
+	double best = shards.error(weights, scale);
+	std::cout << samples.size() << " samples, K = " << scale << ", error " << best << std::endl;
+
+	// Цена простой шашки — единица отсчёта, остальные веса подбираются.
+	double *parameters[] = {&weights.king, &weights.advance, &weights.centre};
+	double steps[] = {0.1, 0.01, 0.01};
+	const double MinStep = 1e-4;
+	for (int pass = 0; pass < passes; ++ pass) {
+		bool improved = false;
+		for (int p = 0; p < 3; ++ p)
+			for (double sign : {+1.0, -1.0}) {
+				double saved = *parameters[p];
+				*parameters[p] = saved + sign*steps[p];
+				if (!bounded(weights)) {
+					*parameters[p] = saved;
+					continue;
+				}
+				double error = shards.error(weights, scale);
+				if (error < best) {
+					best = error;
+					improved = true;
+				}
+				else
+					*parameters[p] = saved;
+			}
+		if (improved) {
+			if (!weights.save(output)) {
+				std::cerr << "Cannot write " << output << '\n';
+				return 1;
+			}
+			std::cout << "pass " << pass << ": error " << best << ", king " << weights.king
+			          << ", advance " << weights.advance << ", centre " << weights.centre << std::endl;
+		}
+		else {
+			bool small = true;
+			for (double &step : steps) {
+				step /= 2.0;
+				small = small && step < MinStep;
+			}
+			if (small)
+				break;
+		}
+	}
+	if (!weights.save(output)) {
+		std::cerr << "Cannot write " << output << '\n';
+		return 1;
+	}
+	std::cout << "final error " << best << ", weights written to " << output << '\n';
+	return 0;
+}
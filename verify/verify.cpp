@@ -0,0 +1,496 @@
+#include "../board/board_state.h"
+#include "../board/minimax.h"
+#include "../board/batch.h"
+#include "../board/network.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Сверка генераторов ходов с автоматом BoardState.
+ *
+ * Для каждой проверяемой позиции программа строит множество позиций, которые
+ * получаются после всех полных ходов, найденных explore() по автомату, и то же
+ * множество по проверяемому генератору. Позиции перебираются полностью до
+ * заданной глубины от начальных позиций, а также собираются из случайных
+ * партий. При расхождении печатается первая (в порядке перебора) позиция,
+ * на которой генераторы не сошлись, и различающиеся продолжения.
+ * Генератор distinct(), кроме того, не должен давать одну позицию дважды:
+ * число его ходов равно числу различных позиций у автомата.
+ *
+ * Кроме того, на тех же позициях признаки BoardState::hasCapture()
+ * и hasMove(), вычисляемые по маскам, сверяются с независимым генератором,
+ * а пачечная оценка каждым доступным ядром — с evaluate(). Для случайной сети
+ * на каждой позиции и каждом её продолжении обновлённый накопитель сверяется
+ * с пересчитанным заново, а скалярное ядро — с AVX2; испорченный файл сети
+ * загружаться не должен.
+ */
+
+namespace {
+
+using Generator = std::vector<BoardState> (*)(const BoardState &board);
+
+std::vector<BoardState> automaton(const BoardState &board) {
+	std::vector<BoardState> result;
+	for (const std::vector<Cell> &action : explore(board)) {
+		BoardState copy = board;
+		BoardState::apply(copy, action);
+		result.push_back(copy);
+	}
+	return result;
+}
+
+/*
+ * Независимый генератор, который не пользуется ни автоматом, ни проверками
+ * Position::accepts() и Position::captures(): только сведениями о полях.
+ * Взятые шашки остаются на доске призраками до конца хода (турецкий удар),
+ * простая шашка, дошедшая до последней горизонтали, продолжает бить как дамка,
+ * дамка обязана выбирать поле приземления, с которого бой продолжается.
+ */
+
+bool empty(const Position &position, Cell cell) {
+	return cell.valid() && !position.color(cell).valid();
+}
+
+// Бить шашкой на поле at; без out только проверить, есть ли что бить.
+bool jump(const Position &position, Cell at, std::vector<Position> *out) {
+	Role color = position.color(at);
+	bool king = position.king(at) || at.promotion(color);
+	bool found = false;
+	for (Direction direction : Direction::enumerate()) {
+		Cell victim = at.neighbour(direction);
+		while (king && empty(position, victim))
+			victim = victim.neighbour(direction);
+		if (!victim.valid() || position.color(victim) != color.opposite() || position.ghost(victim))
+			continue;
+		std::vector<Position> landings;
+		for (Cell land = victim.neighbour(direction); empty(position, land); land = land.neighbour(direction)) {
+			Position next = position;
+			next.kill(victim);
+			next.move(at, land);
+			if (land.promotion(color))
+				next.promote(land);
+			landings.push_back(next);
+			if (!king)
+				break;
+		}
+		if (landings.empty())
+			continue;
+		found = true;
+		if (!out)
+			return true;
+		std::vector<Cell> places;
+		for (Cell land = victim.neighbour(direction); places.size() < landings.size(); land = land.neighbour(direction))
+			places.push_back(land);
+		bool onward = false;
+		for (std::size_t i = 0; i < landings.size(); ++ i)
+			if (jump(landings[i], places[i], nullptr))
+				onward = true;
+		for (std::size_t i = 0; i < landings.size(); ++ i) {
+			if (!onward) {
+				landings[i].removeGhosts();
+				out->push_back(landings[i]);
+			}
+			else if (jump(landings[i], places[i], nullptr))
+				jump(landings[i], places[i], out);
+		}
+	}
+	return found;
+}
+
+std::vector<BoardState> direct(const BoardState &board) {
+	Role color = board.color();
+	const Position &position = board.position();
+	std::vector<Position> out;
+	for (Cell stone : position.stock(color))
+		jump(position, stone, &out);
+	if (out.empty())
+		for (Cell stone : position.stock(color)) {
+			bool king = position.king(stone);
+			for (Direction direction : Direction::enumerate()) {
+				if (!king && !direction.valid(color))
+					continue;
+				for (Cell to = stone.neighbour(direction); empty(position, to); to = to.neighbour(direction)) {
+					Position next = position;
+					next.move(stone, to);
+					if (to.promotion(color))
+						next.promote(to);
+					out.push_back(next);
+					if (!king)
+						break;
+				}
+			}
+		}
+	std::vector<BoardState> result;
+	for (const Position &next : out)
+		result.push_back(BoardState(next, color.opposite()));
+	return result;
+}
+
+// Ходы без повторов итоговых позиций дают то же множество позиций.
+std::vector<BoardState> collapsed(const BoardState &board) {
+	std::vector<BoardState> result;
+	for (const std::vector<Cell> &action : distinct(board)) {
+		BoardState copy = board;
+		BoardState::apply(copy, action);
+		result.push_back(copy);
+	}
+	return result;
+}
+
+struct Entry {
+	const char *name;
+	Generator generator;
+	bool unique;    // Каждая итоговая позиция должна встретиться ровно один раз.
+};
+
+const Entry Generators[] = {
+	{"direct", direct, false},
+	{"distinct", collapsed, true},
+};
+
+std::set<std::string> notations(const std::vector<BoardState> &boards) {
+	std::set<std::string> result;
+	for (const BoardState &board : boards)
+		result.insert(board.str());
+	return result;
+}
+
+void putWord(std::string &out, std::uint32_t value, int bytes) {
+	for (int i = 0; i < bytes; ++ i)
+		out.push_back(static_cast<char>((value >> 8*i) & 0xFF));
+}
+
+// Файл сети со случайными весами; веса малы, чтобы слои редко упирались в пределы.
+std::string randomNetwork(std::mt19937 &random) {
+	auto uniform = [&random] (int low, int high) {
+		return static_cast<std::uint32_t>(std::uniform_int_distribution<int>(low, high)(random));
+	};
+	std::string out = "SHNN";
+	for (std::uint32_t word : {1u, 128u, 32u, 32u})
+		putWord(out, word, 4);
+	for (int i = 0; i < Network::Inputs*Network::Hidden + Network::Hidden; ++ i)
+		putWord(out, uniform(-16, 24), 2);
+	for (int i = 0; i < Network::Second*Network::Hidden; ++ i)
+		putWord(out, uniform(-16, 16), 1);
+	for (int i = 0; i < Network::Second; ++ i)
+		putWord(out, uniform(-1024, 1024), 4);
+	for (int i = 0; i < Network::Second; ++ i)
+		putWord(out, uniform(-127, 127), 1);
+	for (int i = 0; i < 2; ++ i)
+		putWord(out, uniform(-1000, 1000), 4);
+	return out;
+}
+
+std::shared_ptr<const Network> loadNetwork(const std::string &path, const std::string &content,
+                                           Network::Kernel kernel) {
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << content;
+	}
+	std::shared_ptr<const Network> network = Network::load(path, kernel);
+	std::remove(path.c_str());
+	return network;
+}
+
+bool same(const Network::Accumulator &a, const Network::Accumulator &b) {
+	return std::memcmp(a.values, b.values, sizeof(a.values)) == 0;
+}
+
+// Накопители и оценки случайной сети на всех позициях и их продолжениях.
+bool checkNetwork(const std::vector<BoardState> &list, unsigned int seed) {
+	const std::string path = "board_verify.shnn";
+	std::mt19937 random(seed);
+	std::string content = randomNetwork(random);
+	std::string broken[] = {content.substr(0, content.size()-1), content + '\0', content, content};
+	broken[2][0] = 'X';
+	broken[3][4] = 2;
+	for (const std::string &bad : broken)
+		if (loadNetwork(path, bad, Network::Scalar)) {
+			std::cout << "MISMATCH (network) broken file of " << bad.size() << " bytes loaded\n";
+			return false;
+		}
+	std::vector<std::shared_ptr<const Network>> networks;
+	for (Network::Kernel kernel : {Network::Scalar, Network::Avx2})
+		if (Network::supported(kernel)) {
+			networks.push_back(loadNetwork(path, content, kernel));
+			if (!networks.back()) {
+				std::cout << "MISMATCH (network " << Network::name(kernel) << ") cannot load\n";
+				return false;
+			}
+		}
+	for (const BoardState &board : list) {
+		Network::Accumulator parent, scalar;
+		networks[0]->refresh(board.position(), scalar);
+		double expected = networks[0]->evaluate(board, scalar);
+		for (const std::shared_ptr<const Network> &network : networks) {
+			network->refresh(board.position(), parent);
+			if (!same(parent, scalar) || network->evaluate(board, parent) != expected
+			    || network->evaluate(board) != expected) {
+				std::cout << "MISMATCH (network refresh) at " << board.str() << '\n';
+				return false;
+			}
+			for (const BoardState &child : automaton(board)) {
+				Network::Accumulator updated, refreshed;
+				network->update(parent, board.position(), child.position(), updated);
+				network->refresh(child.position(), refreshed);
+				if (!same(updated, refreshed)
+				    || network->evaluate(child, updated) != networks[0]->evaluate(child)) {
+					std::cout << "MISMATCH (network update) at " << board.str() << " to " << child.str() << '\n';
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+struct Options {
+	int depth = 5;          // Глубина полного перебора.
+	int games = 200;        // Число случайных партий.
+	int plies = 200;        // Наибольшая длина случайной партии.
+	unsigned int seed = 1;
+	unsigned int threads = 0;
+	std::vector<std::string> roots;
+	std::vector<const Entry*> generators;
+};
+
+// Все позиции не глубже depth полуходов от корня, без повторов.
+void collect(const BoardState &root, int depth, std::vector<BoardState> &list, std::set<std::string> &seen) {
+	std::vector<BoardState> level = {root};
+	if (seen.insert(root.str()).second)
+		list.push_back(root);
+	for (int d = 0; d < depth; ++ d) {
+		std::vector<BoardState> next;
+		for (const BoardState &board : level)
+			for (const BoardState &child : automaton(board))
+				if (seen.insert(child.str()).second) {
+					list.push_back(child);
+					next.push_back(child);
+				}
+		level.swap(next);
+	}
+}
+
+void playout(const BoardState &root, int plies, std::mt19937 &random, std::vector<BoardState> &list) {
+	BoardState board = root;
+	for (int ply = 0; ply < plies; ++ ply) {
+		list.push_back(board);
+		std::vector<BoardState> children = automaton(board);
+		if (children.empty())
+			break;
+		board = children[random() % children.size()];
+	}
+}
+
+struct Mismatch {
+	std::size_t index;
+	std::string generator;
+	std::set<std::string> missing;   // Есть у автомата, нет у генератора.
+	std::set<std::string> extra;     // Есть у генератора, нет у автомата.
+	std::set<std::string> repeated; // Встречаются у генератора больше одного раза.
+};
+
+class Checker {
+public:
+	Checker(const std::vector<BoardState> &list, const std::vector<const Entry*> &generators)
+		: _list(list), _generators(generators), _next(0), _first(list.size()) {}
+
+	void run(unsigned int threads) {
+		std::vector<std::thread> pool;
+		for (unsigned int i = 0; i < threads; ++ i)
+			pool.emplace_back(&Checker::work, this);
+		for (std::thread &thread : pool)
+			thread.join();
+	}
+
+	bool failed() const {return _first < _list.size();}
+	const Mismatch& mismatch() const {return _mismatch;}
+
+private:
+	void work() {
+		while (true) {
+			std::size_t index = _next++;
+			if (index >= _list.size() || index > _first)
+				return;
+			const BoardState &board = _list[index];
+			std::set<std::string> expected = notations(automaton(board));
+			for (const Entry *entry : _generators) {
+				std::vector<BoardState> boards = entry->generator(board);
+				std::set<std::string> actual = notations(boards);
+				if (actual != expected || (entry->unique && boards.size() != expected.size())) {
+					report(index, entry->name, expected, actual, boards);
+					break;
+				}
+			}
+		}
+	}
+
+	void report(std::size_t index, std::string name, const std::set<std::string> &expected,
+	            const std::set<std::string> &actual, const std::vector<BoardState> &boards) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (index >= _first)
+			return;
+		_first = index;
+		_mismatch.index = index;
+		_mismatch.generator = name;
+		_mismatch.missing.clear();
+		_mismatch.extra.clear();
+		_mismatch.repeated.clear();
+		std::set_difference(expected.begin(), expected.end(), actual.begin(), actual.end(),
+		                    std::inserter(_mismatch.missing, _mismatch.missing.end()));
+		std::set_difference(actual.begin(), actual.end(), expected.begin(), expected.end(),
+		                    std::inserter(_mismatch.extra, _mismatch.extra.end()));
+		std::set<std::string> once;
+		for (const BoardState &next : boards)
+			if (!once.insert(next.str()).second)
+				_mismatch.repeated.insert(next.str());
+	}
+
+private:
+	const std::vector<BoardState> &_list;
+	const std::vector<const Entry*> &_generators;
+	std::atomic<std::size_t> _next;
+	std::atomic<std::size_t> _first;    // Номер первой найденной расходящейся позиции.
+	std::mutex _mutex;
+	Mismatch _mismatch;
+};
+
+const char *DefaultRoots[] = {
+	"W:WA1,C1,E1,G1,B2,D2,F2,H2,A3,C3,E3,G3:BB6,D6,F6,H6,A7,C7,E7,G7,B8,D8,F8,H8",
+	"W:WKC1,E3,G3:BB4,D6,F6,B6,KH8",
+	"B:WKA1,C3,E3,C5,G5:BKH8,F6,B6,D8",
+	"W:WB6,F4,H2:BC7,E7,G5,E5,G3",
+};
+
+void usage() {
+	std::cerr << "Usage: board_verify [--depth N] [--games N] [--plies N] [--seed N]"
+	             " [--threads N] [--weights FILE] [--position NOTATION]... [--generator NAME]...\n";
+	std::cerr << "Generators:";
+	for (const Entry &entry : Generators)
+		std::cerr << ' ' << entry.name;
+	std::cerr << '\n';
+}
+
+}
+
+int main(int argc, char **argv) {
+	Options options;
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+		bool more = i+1 < argc;
+		if (arg == "--depth" && more)
+			options.depth = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--games" && more)
+			options.games = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--plies" && more)
+			options.plies = std::max(0, std::atoi(argv[++ i]));
+		else if (arg == "--seed" && more)
+			options.seed = std::strtoul(argv[++ i], nullptr, 10);
+		else if (arg == "--threads" && more)
+			options.threads = std::strtoul(argv[++ i], nullptr, 10);
+		else if (arg == "--weights" && more) {
+			Weights weights;
+			if (!weights.load(argv[++ i])) {
+				std::cerr << "Cannot load weights from " << argv[i] << '\n';
+				return 1;
+			}
+			useWeights(weights);
+		}
+		else if (arg == "--position" && more)
+			options.roots.push_back(argv[++ i]);
+		else if (arg == "--generator" && more) {
+			std::string name = argv[++ i];
+			const Entry *found = nullptr;
+			for (const Entry &entry : Generators)
+				if (name == entry.name)
+					found = &entry;
+			if (!found) {
+				usage();
+				return 1;
+			}
+			options.generators.push_back(found);
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (options.roots.empty())
+		options.roots.assign(std::begin(DefaultRoots), std::end(DefaultRoots));
+	if (options.generators.empty())
+		for (const Entry &entry : Generators)
+			options.generators.push_back(&entry);
+	if (!options.threads)
+		options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<BoardState> list;
+	std::set<std::string> seen;
+	std::mt19937 random(options.seed);
+	for (const std::string &notation : options.roots) {
+		BoardState root = BoardState::fromString(notation);
+		if (!root.color().valid()) {
+			std::cerr << "Bad position: " << notation << '\n';
+			return 1;
+		}
+		collect(root, options.depth, list, seen);
+		for (int game = 0; game < options.games; ++ game)
+			playout(root, options.plies, random, list);
+	}
+
+	Checker checker(list, options.generators);
+	checker.run(options.threads);
+	if (checker.failed()) {
+		const Mismatch &m = checker.mismatch();
+		std::cout << "MISMATCH (" << m.generator << ") at " << list[m.index].str() << '\n';
+		for (const std::string &s : m.missing)
+			std::cout << "  missing: " << s << '\n';
+		for (const std::string &s : m.extra)
+			std::cout << "  extra:   " << s << '\n';
+		for (const std::string &s : m.repeated)
+			std::cout << "  repeated: " << s << '\n';
+		return 1;
+	}
+	for (const BoardState &board : list) {
+		bool capture = false;
+		for (Cell stone : board.position().stock(board.color()))
+			capture = capture || jump(board.position(), stone, nullptr);
+		bool move = !direct(board).empty();
+		if (board.hasCapture() != capture || board.hasMove() != move) {
+			std::cout << "MISMATCH (hasCapture/hasMove) at " << board.str() << ": " << board.hasCapture()
+			          << '/' << board.hasMove() << " instead of " << capture << '/' << move << '\n';
+			return 1;
+		}
+	}
+	for (Batch::Kernel kernel : {Batch::Scalar, Batch::Popcnt, Batch::Avx2}) {
+		if (!Batch::supported(kernel))
+			continue;
+		Batch batch;
+		for (const BoardState &board : list)
+			batch.append(board);
+		std::vector<double> scores(batch.size());
+		batch.evaluate(scores.data(), kernel);
+		for (std::size_t i = 0; i < list.size(); ++ i)
+			if (scores[i] != evaluate(list[i])) {
+				std::cout << "MISMATCH (batch " << Batch::name(kernel) << ") at " << list[i].str()
+				          << ": " << scores[i] << " instead of " << evaluate(list[i]) << '\n';
+				return 1;
+			}
+	}
+	if (!checkNetwork(list, options.seed))
+		return 1;
+	std::cout << "OK: " << list.size() << " positions, " << options.generators.size()
+	          << " generator(s), " << options.threads << " thread(s)\n";
+	return 0;
+}